@@ -34,7 +34,8 @@ void main() {
     if (specMult > 0 && specular_exponent > 0)
       specMult = pow(specMult, specular_exponent);
     specular *= specMult;
-    diffuseColor = vec4(specular + diffuse + ambient, globalColor.w);
+    // Vertex colors carry the color of batched rects
+    diffuseColor = vec4(specular + diffuse + ambient, 1) * color * vec4(1, 1, 1, globalColor.w);
     if (textured == 1)
       diffuseColor *= texture(tex, texPos);
   }
@@ -11,9 +11,17 @@ uniform mat4 objectMatrix;
 uniform mat4 screenMatrix;
 uniform mat4 normalMatrix;
 uniform float zoom;
+uniform int octNormals;
+// Compact meshes store the normal octahedrally encoded in xy
+vec4 octDecode(vec4 e) {
+  vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+  if (n.z < 0.0)
+    n.xy = (1.0 - abs(n.yx)) * vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);
+  return vec4(normalize(n), 0.0);
+}
 void main() {
   worldPosition = objectMatrix * pos * zoom;
-  worldNormal = normalMatrix * normal;
+  worldNormal = normalMatrix * (octNormals != 0 ? octDecode(normal) : normal);
   gl_Position = screenMatrix * worldPosition;
   texPos = texcoord;
   color = vecColor;
@@ -3,26 +3,68 @@ layout(location = 0) in vec4 pos;
 layout(location = 1) in vec4 vecColor;
 layout(location = 3) in vec2 texcoord;
 layout(location = 2) in vec4 normal;
+// Where the calls of the draw start in RenderBuffer, multi draws can not read their base instance
+layout(location = 7) in uint instanceBase;
 layout(location = 0) out vec2 texPos;
 layout(location = 1) out vec4 color;
 layout(location = 2) out vec4 worldNormal;
 layout(location = 3) out vec4 worldPosition;
-layout(location = 4) out flat int InstanceID;
-struct buff {
-  mat4 matrix;
-  mat4 normalMatrix;
+layout(location = 4) out flat int materialID;
+layout(location = 5) out flat vec3 instanceColor;
+struct affineInstance {
+  vec4 rows[3];
   vec3 color;
   int materialID;
 };
-layout(std430, binding = 0) buffer RenderBuffer { buff data[]; };
+struct flatInstance {
+  vec2 position;
+  vec2 scale;
+  float rotation;
+  float depth;
+  uint color;
+  int materialID;
+};
+// Both read the instance ring, instanceFormat says which one the calls are in
+layout(std430, binding = 0) buffer RenderBuffer { affineInstance data[]; };
+layout(std430, binding = 0) buffer FlatRenderBuffer { flatInstance flatData[]; };
+uniform int instanceFormat;
 uniform mat4 screenMatrix;
 uniform float zoom;
+uniform int octNormals;
+// Compact meshes store the normal octahedrally encoded in xy
+vec4 octDecode(vec4 e) {
+  vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+  if (n.z < 0.0)
+    n.xy = (1.0 - abs(n.yx)) * vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);
+  return vec4(normalize(n), 0.0);
+}
 void main() {
-  int instance = gl_InstanceID;
-  InstanceID = instance;
-  buff b = data[instance];
-  worldPosition = b.matrix * pos * zoom;
-  worldNormal = b.normalMatrix * normal;
+  int instance = gl_InstanceID + int(instanceBase);
+  vec4 normalIn = octNormals != 0 ? octDecode(normal) : normal;
+  if (instanceFormat == 1) {
+    flatInstance f = flatData[instance];
+    float c = cos(f.rotation);
+    float s = sin(f.rotation);
+    mat2 rotation = mat2(c, s, -s, c);
+    worldPosition = vec4(rotation * (f.scale * pos.xy) + f.position, pos.z + f.depth, 1) * zoom;
+    // Turning and scaling by the inverse is the inverse transpose of a rotation and scale
+    worldNormal = vec4(rotation * (normalIn.xy / f.scale), normalIn.z, 0);
+    instanceColor = unpackUnorm4x8(f.color).rgb;
+    materialID = f.materialID;
+  } else {
+    affineInstance a = data[instance];
+    mat4 matrix = transpose(mat4(a.rows[0], a.rows[1], a.rows[2], vec4(0, 0, 0, 1)));
+    vec3 x = matrix[0].xyz;
+    vec3 y = matrix[1].xyz;
+    vec3 z = matrix[2].xyz;
+    // The cofactors are the inverse transpose times the determinant, its sign keeps mirrored normals facing out
+    mat3 cofactor = mat3(cross(y, z), cross(z, x), cross(x, y));
+    float handedness = dot(x, cross(y, z)) < 0.0 ? -1.0 : 1.0;
+    worldPosition = matrix * pos * zoom;
+    worldNormal = vec4(cofactor * normalIn.xyz * handedness, 0);
+    instanceColor = a.color;
+    materialID = a.materialID;
+  }
   gl_Position = screenMatrix * worldPosition;
   texPos = texcoord;
   color = vecColor;
@@ -0,0 +1,6 @@
+#version 450
+layout(location = 0) in vec4 color;
+out vec4 diffuseColor;
+void main() {
+  diffuseColor = color;
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#version 450
+// Lines are read straight from the point buffer, every segment is 9 verticies: a quad and a join triangle
+struct linePoint {
+  vec4 position;
+  vec4 color;
+  float thickness;
+  uint flags;
+  vec2 padding;
+};
+layout(std430, binding = 2) readonly buffer LinePoints { linePoint points[]; };
+layout(location = 0) out vec4 color;
+uniform mat4 screenMatrix;
+uniform float zoom;
+uniform vec2 viewport;
+// The last point of a line, nothing connects it to the next one
+const uint lineEnd = 1u;
+// The join at this point is cut off instead of mitered
+const uint lineBevel = 2u;
+// Miters longer than this many half thicknesses are bevelled instead
+const float miterLimit = 4.0;
+const int quadEnd[6] = int[](0, 0, 1, 0, 1, 1);
+const float quadSide[6] = float[](-1, 1, 1, -1, 1, -1);
+
+vec4 toClip(int i) {
+  return screenMatrix * (vec4(points[i].position.xyz, 1) * zoom);
+}
+// Pixels from the center of the viewport
+vec2 toScreen(vec4 clip) {
+  return clip.xy / clip.w * viewport * 0.5;
+}
+vec2 normalOf(vec2 from, vec2 to) {
+  vec2 d = to - from;
+  if (dot(d, d) == 0.0)
+    return vec2(0, 1);
+  d = normalize(d);
+  return vec2(-d.y, d.x);
+}
+// Both segments at a point get the same offset, so the miter closes the gap between them
+bool miter(int i, vec2 before, vec2 after, out vec2 offset) {
+  vec2 m = before + after;
+  if ((points[i].flags & lineBevel) != 0u || dot(m, m) < 0.0001)
+    return false;
+  m = normalize(m);
+  float scale = 1.0 / dot(m, after);
+  if (scale > miterLimit)
+    return false;
+  offset = m * scale;
+  return true;
+}
+void main() {
+  int a = gl_VertexID / 9;
+  int corner = gl_VertexID % 9;
+  // Nothing to draw past the end of a line, the last point of the buffer has no point after it
+  if ((points[a].flags & lineEnd) != 0u) {
+    gl_Position = vec4(0, 0, 0, 1);
+    color = vec4(0);
+    return;
+  }
+  int b = a + 1;
+  vec4 clipA = toClip(a);
+  vec4 clipB = toClip(b);
+  // Or behind the camera
+  if (clipA.w <= 0.0 || clipB.w <= 0.0) {
+    gl_Position = vec4(0, 0, 0, 1);
+    color = vec4(0);
+    return;
+  }
+  vec2 screenA = toScreen(clipA);
+  vec2 screenB = toScreen(clipB);
+  vec2 n = normalOf(screenA, screenB);
+  vec2 offsetA = n;
+  vec2 offsetB = n;
+  if (a > 0 && (points[a - 1].flags & lineEnd) == 0u) {
+    vec4 before = toClip(a - 1);
+    if (before.w > 0.0)
+      miter(a, normalOf(toScreen(before), screenA), n, offsetA);
+  }
+  bool join = false;
+  vec2 next = n;
+  if ((points[b].flags & lineEnd) == 0u) {
+    vec4 after = toClip(b + 1);
+    if (after.w > 0.0) {
+      next = normalOf(screenB, toScreen(after));
+      join = !miter(b, n, next, offsetB);
+    }
+  }
+
+  int end;
+  vec2 offset;
+  if (corner < 6) {
+    end = quadEnd[corner];
+    offset = (end == 0 ? offsetA : offsetB) * quadSide[corner];
+  } else {
+    // Bevels fill the outside of the turn, the inside is already covered
+    end = 1;
+    float side = dot(next, screenB - screenA) < 0.0 ? -1.0 : 1.0;
+    offset = join && corner != 6 ? (corner == 7 ? n : next) * side : vec2(0);
+  }
+  vec4 clip = end == 0 ? clipA : clipB;
+  vec2 screen = (end == 0 ? screenA : screenB) + offset * points[a + end].thickness * 0.5;
+  gl_Position = vec4(screen / (viewport * 0.5) * clip.w, clip.z, clip.w);
+  color = points[a + end].color;
+}
\ No newline at end of file
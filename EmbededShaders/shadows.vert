@@ -3,17 +3,38 @@ layout(location = 0) in vec4 pos;
 layout(location = 1) in vec4 vecColor;
 layout(location = 3) in vec2 texcoord;
 layout(location = 2) in vec4 normal;
-struct buff {
-  mat4 matrix;
-  mat4 normalMatrix;
+// Where the calls of the draw start in RenderBuffer, multi draws can not read their base instance
+layout(location = 7) in uint instanceBase;
+struct affineInstance {
+  vec4 rows[3];
   vec3 color;
   int materialID;
 };
-layout(std430, binding = 0) buffer RenderBuffer { buff data[]; };
+struct flatInstance {
+  vec2 position;
+  vec2 scale;
+  float rotation;
+  float depth;
+  uint color;
+  int materialID;
+};
+// Both read the instance ring, instanceFormat says which one the calls are in
+layout(std430, binding = 0) buffer RenderBuffer { affineInstance data[]; };
+layout(std430, binding = 0) buffer FlatRenderBuffer { flatInstance flatData[]; };
+uniform int instanceFormat;
 uniform mat4 screenMatrix;
 uniform float zoom;
 void main() {
-  int instance = gl_InstanceID;
-  buff b = data[instance];
-  gl_Position = screenMatrix * b.matrix * pos * zoom;
+  int instance = gl_InstanceID + int(instanceBase);
+  vec4 world;
+  if (instanceFormat == 1) {
+    flatInstance f = flatData[instance];
+    float c = cos(f.rotation);
+    float s = sin(f.rotation);
+    world = vec4(mat2(c, s, -s, c) * (f.scale * pos.xy) + f.position, pos.z + f.depth, 1);
+  } else {
+    affineInstance a = data[instance];
+    world = transpose(mat4(a.rows[0], a.rows[1], a.rows[2], vec4(0, 0, 0, 1))) * pos;
+  }
+  gl_Position = screenMatrix * world * zoom;
 }
\ No newline at end of file
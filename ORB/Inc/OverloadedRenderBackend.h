@@ -116,6 +116,39 @@ typedef ORB_ENUM NONPRINTINGKEYS ORB_ETYPE(int)
     RIGHT_SHIFT = 229,
 }NONPRINTINGKEYS;
 
+typedef ORB_ENUM MESH_STATE ORB_ETYPE(int)
+{
+  MESH_LOADING,
+  MESH_READY,
+  MESH_FAILED,
+}MESH_STATE;
+
+typedef ORB_ENUM VERTEX_FORMAT ORB_ETYPE(int)
+{
+  VERTEX_FULL,
+  VERTEX_COMPACT,
+  VERTEX_COMPACT_2D,
+}VERTEX_FORMAT;
+
+typedef ORB_ENUM NORMAL_MODE ORB_ETYPE(int)
+{
+  NORMAL_FLAT,
+  NORMAL_SMOOTH,
+  NORMAL_SMOOTH_ANGLE,
+}NORMAL_MODE;
+
+typedef ORB_ENUM INSTANCE_FORMAT ORB_ETYPE(int)
+{
+  INSTANCE_AFFINE,
+  INSTANCE_2D,
+}INSTANCE_FORMAT;
+
+typedef ORB_ENUM LINE_JOIN ORB_ETYPE(int)
+{
+  LINE_JOIN_MITER,
+  LINE_JOIN_BEVEL,
+}LINE_JOIN;
+
 typedef ORB_ENUM SAMPLE_SCALE_MODE ORB_ETYPE(int)
 {
   linear,
@@ -208,6 +241,17 @@ typedef struct Vector4D
 #endif
 }Vector4D;
 
+/**
+ * @brief A vertex of a mesh, laid out like the arguments of MeshAddVertex.
+ */
+typedef struct MeshVertex
+{
+  Vector3D pos;
+  Vector4D color;
+  Vector2D UV;
+  Vector4D norm;
+}MeshVertex;
+
 
 #ifdef __cplusplus
 namespace orb
@@ -250,8 +294,59 @@ namespace orb
    * automatically executed on each shader stage that contains a vertex and fragment shader.
    * This will also ignore any passed render layer and instead render to the layer specified to the mesh. 
    * 
+   * DrawMesh, SetColor, SetMatrix and SetMaterial can be called from any thread while stored render is on, each
+   * thread keeps its own color, matrix and material. Every thread has to be done drawing before Update is called.
    */
   extern ORB_SPEC void EnableStoredRender(bool b);
+  /**
+   * @brief Set the hot reload mode.
+   *
+   * @details If hot reload is enabled, the render pass, shader stages and meshes are watched on disk.
+   * When one of the files changes only the object built from it is rebuilt, between frames.
+   * Meshes are parsed in the background and keep drawing their old geometry until the new one is ready.
+   */
+  extern ORB_SPEC void EnableHotReload(bool b);
+  /**
+   * @brief Set the mesh optimization mode.
+   *
+   * @details If enabled, indexed triangle meshes are reordered when they are built so the GPU transforms fewer
+   * verticies and draws less overdraw. Building a mesh takes longer, the average cache miss ratio before and
+   * after is logged for every mesh. Meshes that are already built are not changed.
+   */
+  extern ORB_SPEC void EnableMeshOptimization(bool b);
+  /**
+   * @brief Set the mesh level of detail mode. (Default = true)
+   *
+   * @details If enabled, loaded triangle meshes with enough triangles get up to 3 simplified versions, each with
+   * about half the triangles of the last. Meshes are drawn with the simplest version that is off by less than a
+   * pixel at their size on screen. Only meshes loaded afterwards are affected.
+   */
+  extern ORB_SPEC void EnableMeshLOD(bool b);
+  /**
+   * @brief Set how normals are calculated for meshes that do not come with their own. (Default = NORMAL_FLAT)
+   *
+   * @details NORMAL_FLAT gives every triangle its own normal. NORMAL_SMOOTH averages the normals of the triangles
+   * around each position weighted by their area, NORMAL_SMOOTH_ANGLE weights them by the angle of the corner
+   * instead. Triangle lists, strips and fans are all handled. Only meshes built afterwards are affected.
+   */
+  extern ORB_SPEC void SetNormalMode(NORMAL_MODE mode);
+  /**
+   * @brief Set the frustum culling mode. (Default = true)
+   *
+   * @details If enabled, meshes whose bounds are entirely outside the camera's view are not drawn, and stored
+   * draws that are off screen are dropped before they are written to the render buffer. Turn it off if a custom
+   * shader moves verticies outside the bounds of their mesh.
+   */
+  extern ORB_SPEC void EnableFrustumCulling(bool b);
+  /**
+   * @brief Set whether immediate draws are sorted before they are submitted. (Default = true)
+   *
+   * @details If enabled, immediate draws are grouped by layer, blend mode and fill mode. Opaque draws are drawn front
+   * to back, and meshes among them at the same depth are grouped by texture and material. Draws that blend and are
+   * textured or have a color alpha below 1 are drawn back to front. Rects and blended draws at the same depth keep
+   * the order they were called in. Vertex alpha is not checked, turn it off to submit every draw in call order.
+   */
+  extern ORB_SPEC void EnableDrawSorting(bool b);
 
   /**
    * @brief Register a function to be called during rendering.
@@ -410,6 +505,27 @@ namespace orb
  */
   extern ORB_SPEC void ORB_API DrawLine(Vector2D start, Vector2D end, int depth = 1);
   extern ORB_SPEC void ORB_API DrawLine(Vector3D start, Vector3D end, int depth = 1);
+  /**
+   * @brief Draws a line through several points.
+   *
+   * @param points - The points to go through in order.
+   * @param count  - How many points there are, less than 2 draws nothing.
+   * @param depth  - The depth or layer on which the line will be rendered (default is 1).
+   *
+   * @note Lines are batched and drawn at the end of the render stage, on top of the other draws to their layer.
+   */
+  extern ORB_SPEC void ORB_API DrawPolyline(Vector3D const* points, int count, int depth = 1);
+  /**
+   * @brief Set how wide lines drawn afterwards are in pixels. (Default = 1)
+   */
+  extern ORB_SPEC void ORB_API SetLineThickness(float thickness);
+  /**
+   * @brief Set how the segments of lines drawn afterwards meet. (Default = LINE_JOIN_MITER)
+   *
+   * @details LINE_JOIN_MITER extends the edges until they meet, very sharp corners are bevelled instead so they do
+   * not reach too far. LINE_JOIN_BEVEL always cuts the corner off.
+   */
+  extern ORB_SPEC void ORB_API SetLineJoin(LINE_JOIN join);
   /**
    * @brief Set the project mode to use, default behavior is orthogonal projection.
    *
@@ -550,10 +666,25 @@ namespace orb
    * @brief Start a new default Mesh.
    */
   extern ORB_SPEC void ORB_API BeginMesh();
+  /**
+   * @brief Start a new default Mesh stored in a smaller vertex format.
+   *
+   * @param format - VERTEX_FULL: 56 bytes a vertex, nothing is lost
+   *                 VERTEX_COMPACT: 20 bytes, half float positions, 8 bit colors, 16 bit normals and UVs
+   *                 VERTEX_COMPACT_2D: 12 bytes, half float x and y, 8 bit colors, 16 bit UVs and no normals
+   * Compact UVs are clamped to 0-1 and positions keep about 3 significant digits.
+   * Every format feeds locations 0-3 (position, color, normal, UV). Location 7 is reserved, the mesh VAOs feed the
+   * base instance of stored draws there, so custom shader stages must not declare an input at it.
+   */
+  extern ORB_SPEC void ORB_API BeginMesh(VERTEX_FORMAT format);
   /**
    * @brief Start a new Textured Mesh.
    */
   extern ORB_SPEC void ORB_API BeginTexMesh();
+  /**
+   * @brief Start a new Textured Mesh stored in a smaller vertex format, see BeginMesh(VERTEX_FORMAT).
+   */
+  extern ORB_SPEC void ORB_API BeginTexMesh(VERTEX_FORMAT format);
   /**
    * @brief Set the Drawmode of the Mesh. (Default = 6)
    *
@@ -597,10 +728,39 @@ namespace orb
    * @brief End the mesh creation and return handle to internal mesh.
    */
   extern ORB_SPEC ORB_mesh ORB_API EndMesh();
+  /**
+   * @brief Keep the verticies of the active mesh in the order they were added, so MeshUpdateVertices can find them.
+   *
+   * @details Meshes are normally welded and reordered when they end, which moves verticies around. Call this
+   * before EndMesh for meshes that will be updated.
+   */
+  extern ORB_SPEC void ORB_API MeshSetDynamic();
+  /**
+   * @brief Replace some of the verticies of a mesh, for meshes that change every frame.
+   *
+   * @details The first update gives the mesh a triple buffered ring of its verticies, later updates write the
+   * copy the GPU is not reading, so they neither stall nor reallocate. Normals are used as given.
+   *
+   * @param m      - the mesh to update
+   * @param offset - the first vertex to replace
+   * @param count  - how many verticies to replace
+   * @param data   - the new verticies
+   * @return false if the range is past the end of the mesh or the mesh is not loaded yet
+   */
+  extern ORB_SPEC bool ORB_API MeshUpdateVertices(ORB_mesh m, int offset, int count, MeshVertex const* data);
+  /**
+   * @brief Set how the stored render calls of a mesh are sent to the GPU.
+   *
+   * @param m      - the mesh
+   * @param format - INSTANCE_AFFINE: 64 bytes a call, any matrix without projection
+   *                 INSTANCE_2D: 32 bytes, only position, rotation around z and scale are kept, colors are clamped to 0-1
+   * Calls already queued this frame are dropped.
+   */
+  extern ORB_SPEC void ORB_API MeshSetInstanceFormat(ORB_mesh m, INSTANCE_FORMAT format);
   /**
    * @brief Create a mesh from a file path.
    *
-   * @param path - path to mesh to load
+   * @param path - path to mesh to load (.dat, .obj or .orbm)
    */
   extern ORB_SPEC ORB_mesh ORB_API LoadMesh(const char*);
   extern ORB_SPEC ORB_mesh ORB_API LoadMesh( std::string& s);
@@ -612,6 +772,43 @@ namespace orb
    */
   extern ORB_SPEC ORB_mesh ORB_API LoadTexMesh(const char* c);
   extern ORB_SPEC ORB_mesh ORB_API LoadTexMesh( std::string& s);
+  /**
+   * @brief Convert a .dat or .obj mesh into the binary .orbm format.
+   * Binary meshes are mapped and uploaded without parsing, load them with LoadMesh/LoadTexMesh.
+   *
+   * @param source - path to the .dat or .obj mesh
+   * @param destination - path of the .orbm file to write
+   * @return whether the conversion succeeded
+   */
+  extern ORB_SPEC bool ORB_API ConvertMesh(const char* source, const char* destination);
+  /**
+   * @brief Start loading a mesh in the background.
+   * The handle is returned right away and draws nothing until its state is MESH_READY.
+   *
+   * @param path - path to mesh to load (.dat, .obj or .orbm)
+   */
+  extern ORB_SPEC ORB_mesh ORB_API LoadMeshAsync(const char* path);
+  extern ORB_SPEC ORB_mesh ORB_API LoadMeshAsync( std::string& path);
+  extern ORB_SPEC ORB_mesh ORB_API LoadTexMeshAsync(const char* path);
+  extern ORB_SPEC ORB_mesh ORB_API LoadTexMeshAsync( std::string& path);
+  /**
+   * @brief Get the loading state of a mesh.
+   *
+   * @param m - the mesh
+   * @return MESH_LOADING while the file is read, then MESH_READY or MESH_FAILED
+   */
+  extern ORB_SPEC MESH_STATE ORB_API MeshGetState(ORB_mesh m);
+  /**
+   * @brief Delete a mesh.
+   * Loading the same file again returns the same mesh, it is only deleted once every load of it is deleted.
+   */
+  extern ORB_SPEC void ORB_API DeleteMesh(ORB_mesh m);
+  /**
+   * @brief Cache parsed .dat and .obj meshes as binary files, later loads of an unchanged file skip parsing.
+   *
+   * @param directory - where to keep the cache, created if it does not exist. An empty path turns the cache off
+   */
+  extern ORB_SPEC void ORB_API SetMeshCacheDirectory(const char* directory);
   /**
    * @brief Draw a mesh object.
    *
@@ -858,6 +1055,12 @@ extern ORB_SPEC void SetMaterial(int id);
 extern ORB_SPEC void SetLight(Vector4D pos, Vector3D color);
 
 extern ORB_SPEC void EnableStoredRender(bool b);
+extern ORB_SPEC void EnableHotReload(bool b);
+extern ORB_SPEC void EnableMeshOptimization(bool b);
+extern ORB_SPEC void EnableMeshLOD(bool b);
+extern ORB_SPEC void SetNormalMode(NORMAL_MODE mode);
+extern ORB_SPEC void EnableFrustumCulling(bool b);
+extern ORB_SPEC void EnableDrawSorting(bool b);
 /**
  * @brief Register a function to be called during rendering.
  *
@@ -991,6 +1194,24 @@ extern ORB_SPEC void ORB_API SetDrawColor(uchar r, uchar g, uchar b, uchar a);
 * @note The depth parameter is used to control the rendering order, with lower values rendering behind higher values.
 */
 extern ORB_SPEC void ORB_API DrawLine(Vector3D start, Vector3D end, int depth);
+/**
+ * @brief Draws a line through several points.
+ *
+ * @param points - The points to go through in order.
+ * @param count  - How many points there are, less than 2 draws nothing.
+ * @param depth  - The depth or layer on which the line will be rendered.
+ *
+ * @note Lines are batched and drawn at the end of the render stage, on top of the other draws to their layer.
+ */
+extern ORB_SPEC void ORB_API DrawPolyline(Vector3D const* points, int count, int depth);
+/**
+ * @brief Set how wide lines drawn afterwards are in pixels. (Default = 1)
+ */
+extern ORB_SPEC void ORB_API SetLineThickness(float thickness);
+/**
+ * @brief Set how the segments of lines drawn afterwards meet. (Default = LINE_JOIN_MITER)
+ */
+extern ORB_SPEC void ORB_API SetLineJoin(LINE_JOIN join);
 /**
  * @brief Set the project mode to use, default behavior is orthogonal projection.
  *
@@ -1104,6 +1325,21 @@ extern ORB_SPEC void ORB_API BeginMesh();
  * @brief Start a new Textured Mesh.
  */
 extern ORB_SPEC void ORB_API BeginTexMesh();
+/**
+ * @brief Start a new default Mesh stored in a smaller vertex format.
+ *
+ * @param format - VERTEX_FULL: 56 bytes a vertex, nothing is lost
+ *                 VERTEX_COMPACT: 20 bytes, half float positions, 8 bit colors, 16 bit normals and UVs
+ *                 VERTEX_COMPACT_2D: 12 bytes, half float x and y, 8 bit colors, 16 bit UVs and no normals
+ * Compact UVs are clamped to 0-1 and positions keep about 3 significant digits.
+ * Every format feeds locations 0-3 (position, color, normal, UV). Location 7 is reserved, the mesh VAOs feed the
+ * base instance of stored draws there, so custom shader stages must not declare an input at it.
+ */
+extern ORB_SPEC void ORB_API BeginMeshWithFormat(VERTEX_FORMAT format);
+/**
+ * @brief Start a new Textured Mesh stored in a smaller vertex format, see BeginMeshWithFormat.
+ */
+extern ORB_SPEC void ORB_API BeginTexMeshWithFormat(VERTEX_FORMAT format);
 /**
  * @brief Set the Drawmode of the Mesh. (Default = 6)
  *
@@ -1141,10 +1377,31 @@ extern ORB_SPEC void ORB_API TexMeshSetTextureFromString(const char* s);
  * @brief End the mesh creation and return handle to internal mesh.
  */
 extern ORB_SPEC ORB_mesh ORB_API EndMesh();
+/**
+ * @brief Keep the verticies of the active mesh in the order they were added, so MeshUpdateVertices can find them.
+ */
+extern ORB_SPEC void ORB_API MeshSetDynamic();
+/**
+ * @brief Replace some of the verticies of a mesh, for meshes that change every frame.
+ *
+ * @param m      - the mesh to update
+ * @param offset - the first vertex to replace
+ * @param count  - how many verticies to replace
+ * @param data   - the new verticies
+ * @return false if the range is past the end of the mesh or the mesh is not loaded yet
+ */
+extern ORB_SPEC bool ORB_API MeshUpdateVertices(ORB_mesh m, int offset, int count, MeshVertex const* data);
+/**
+ * @brief Set how the stored render calls of a mesh are sent to the GPU.
+ *
+ * @param m      - the mesh
+ * @param format - INSTANCE_AFFINE: 64 bytes a call, INSTANCE_2D: 32 bytes, only 2D transforms
+ */
+extern ORB_SPEC void ORB_API MeshSetInstanceFormat(ORB_mesh m, INSTANCE_FORMAT format);
 /**
  * @brief Create a mesh from a file path.
  *
- * @param path - path to mesh to load
+ * @param path - path to mesh to load (.dat, .obj or .orbm)
  */
 extern ORB_SPEC ORB_mesh ORB_API LoadMesh(const char*);
 
@@ -1154,6 +1411,41 @@ extern ORB_SPEC ORB_mesh ORB_API LoadMesh(const char*);
  * @param path - path to teh mesh to load
  */
 extern ORB_SPEC ORB_mesh ORB_API LoadTexMesh(const char* c);
+/**
+ * @brief Convert a .dat or .obj mesh into the binary .orbm format.
+ * Binary meshes are mapped and uploaded without parsing, load them with LoadMesh/LoadTexMesh.
+ *
+ * @param source - path to the .dat or .obj mesh
+ * @param destination - path of the .orbm file to write
+ * @return whether the conversion succeeded
+ */
+extern ORB_SPEC bool ORB_API ConvertMesh(const char* source, const char* destination);
+/**
+ * @brief Start loading a mesh in the background.
+ * The handle is returned right away and draws nothing until its state is MESH_READY.
+ *
+ * @param path - path to mesh to load (.dat, .obj or .orbm)
+ */
+extern ORB_SPEC ORB_mesh ORB_API LoadMeshAsync(const char* path);
+extern ORB_SPEC ORB_mesh ORB_API LoadTexMeshAsync(const char* path);
+/**
+ * @brief Get the loading state of a mesh.
+ *
+ * @param m - the mesh
+ * @return MESH_LOADING while the file is read, then MESH_READY or MESH_FAILED
+ */
+extern ORB_SPEC MESH_STATE ORB_API MeshGetState(ORB_mesh m);
+/**
+ * @brief Delete a mesh.
+ * Loading the same file again returns the same mesh, it is only deleted once every load of it is deleted.
+ */
+extern ORB_SPEC void ORB_API DeleteMesh(ORB_mesh m);
+/**
+ * @brief Cache parsed .dat and .obj meshes as binary files, later loads of an unchanged file skip parsing.
+ *
+ * @param directory - where to keep the cache, created if it does not exist. An empty path turns the cache off
+ */
+extern ORB_SPEC void ORB_API SetMeshCacheDirectory(const char* directory);
 /**
  * @brief Draw a mesh object.
  *
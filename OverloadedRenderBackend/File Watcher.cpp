@@ -0,0 +1,123 @@
+#include "pch.h"
+#include "File Watcher.h"
+#include "ShaderLog.hpp"
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// How often the watcher thread checks for changes or for being stopped
+constexpr int WatchInterval = 100;
+
+static std::filesystem::file_time_type WriteTime(std::string const& path)
+{
+  std::error_code error;
+  auto time = std::filesystem::last_write_time(path, error);
+  return error ? std::filesystem::file_time_type() : time;
+}
+
+FileWatcher::FileWatcher()
+{
+#ifdef __linux__
+  _inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (_inotify == -1)
+    Log(Warning, "inotify unavailable, polling watched files instead");
+#endif
+  _thread = std::thread(&FileWatcher::Run, this);
+}
+
+FileWatcher::~FileWatcher()
+{
+  _running = false;
+  if (_thread.joinable())
+    _thread.join();
+#ifdef __linux__
+  if (_inotify != -1)
+    close(_inotify);
+#endif
+}
+
+std::string FileWatcher::Normalize(std::string const& path)
+{
+  std::error_code error;
+  auto full = std::filesystem::weakly_canonical(path, error);
+  if (error)
+    return std::filesystem::path(path).lexically_normal().generic_string();
+  return full.generic_string();
+}
+
+void FileWatcher::Watch(std::string const& path)
+{
+  std::string file = Normalize(path);
+  std::lock_guard<std::mutex> guard(_lock);
+  if (_files.contains(file))
+    return;
+  _files[file] = WriteTime(file);
+#ifdef __linux__
+  if (_inotify == -1)
+    return;
+  std::string directory = std::filesystem::path(file).parent_path().generic_string();
+  // Adding the same directory again hands back the same descriptor
+  int wd = inotify_add_watch(_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+  if (wd == -1)
+    Log(Warning, "Could not watch", directory);
+  else
+    _directories[wd] = directory;
+#endif
+}
+
+std::vector<std::string> FileWatcher::Changes()
+{
+  std::vector<std::string> result;
+  // The frame never waits on the watcher, anything missed is picked up next frame
+  std::unique_lock<std::mutex> guard(_lock, std::try_to_lock);
+  if (!guard.owns_lock() || _changed.empty())
+    return result;
+  result.assign(_changed.begin(), _changed.end());
+  _changed.clear();
+  return result;
+}
+
+void FileWatcher::Run()
+{
+  while (_running)
+  {
+#ifdef __linux__
+    if (_inotify != -1)
+    {
+      pollfd fd = {_inotify, POLLIN, 0};
+      if (poll(&fd, 1, WatchInterval) <= 0)
+        continue;
+      alignas(inotify_event) char buffer[4096];
+      ssize_t length;
+      while ((length = read(_inotify, buffer, sizeof(buffer))) > 0)
+      {
+        std::lock_guard<std::mutex> guard(_lock);
+        for (char* it = buffer; it < buffer + length;)
+        {
+          inotify_event const* event = reinterpret_cast<inotify_event const*>(it);
+          it += sizeof(inotify_event) + event->len;
+          auto directory = _directories.find(event->wd);
+          if (directory == _directories.end() || event->len == 0)
+            continue;
+          std::string file = directory->second + "/" + event->name;
+          if (_files.contains(file))
+            _changed.insert(file);
+        }
+      }
+      continue;
+    }
+#endif
+    std::this_thread::sleep_for(std::chrono::milliseconds(WatchInterval));
+    std::lock_guard<std::mutex> guard(_lock);
+    for (auto& file : _files)
+    {
+      auto time = WriteTime(file.first);
+      if (time == file.second)
+        continue;
+      file.second = time;
+      _changed.insert(file.first);
+    }
+  }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <atomic>
+
+/**
+ * @brief Watches files on a background thread and collects the ones that changed.
+ *
+ * Uses inotify on Linux and polls the write times everywhere else. Nothing is reloaded
+ * here, the owner drains Changes() between frames and decides what to rebuild.
+ */
+class FileWatcher
+{
+public:
+  FileWatcher();
+  ~FileWatcher();
+
+  FileWatcher(FileWatcher const&) = delete;
+  FileWatcher& operator=(FileWatcher const&) = delete;
+
+  /**
+   * @brief Start watching a file, watching a file twice does nothing.
+   *
+   * @param path the file to watch
+   */
+  void Watch(std::string const& path);
+
+  /**
+   * @brief Take every file that changed since the last call.
+   *
+   * @return the changed files as Normalize'd paths, never blocks on the watcher thread
+   */
+  std::vector<std::string> Changes();
+
+  /**
+   * @brief Turn a path into the form the watcher reports, so paths can be compared.
+   *
+   * @param path the path
+   * @return the absolute path with generic separators
+   */
+  static std::string Normalize(std::string const& path);
+
+private:
+  void Run();
+
+  std::mutex _lock;
+  std::thread _thread;
+  std::atomic<bool> _running = true;
+  // Watched files and their last write time, the time is only used when polling
+  std::unordered_map<std::string, std::filesystem::file_time_type> _files;
+  std::unordered_set<std::string> _changed;
+#ifdef __linux__
+  int _inotify = -1;
+  // Watch descriptor to directory, files are watched through their directory so replacing a file is seen too
+  std::unordered_map<int, std::string> _directories;
+#endif
+};
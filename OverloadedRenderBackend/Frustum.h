@@ -0,0 +1,64 @@
+#pragma once
+#include <glm.hpp>
+
+/**
+ * @brief The six planes around what a projection can see, xyz is the normal pointing in and w the distance.
+ */
+typedef struct Frustum
+{
+  glm::vec4 planes[6];
+
+  /**
+   * @brief Pull the planes out of a projection (Gribb and Hartmann), they are in the space the matrix projects from.
+   *
+   * @param m the projection, with the camera if the planes should be in world space
+   */
+  static Frustum FromMatrix(glm::mat4 const& m)
+  {
+    // glm is column major, so the rows are strided
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i)
+      rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+    Frustum f;
+    for (int i = 0; i < 3; ++i)
+    {
+      f.planes[i * 2] = rows[3] + rows[i];
+      f.planes[i * 2 + 1] = rows[3] - rows[i];
+    }
+    for (auto& p : f.planes)
+    {
+      float length = glm::length(glm::vec3(p));
+      if (length > 0)
+        p /= length;
+    }
+    return f;
+  }
+
+  /**
+   * @brief Whether any of a sphere might be inside.
+   */
+  bool SphereVisible(glm::vec3 center, float radius) const
+  {
+    for (auto const& p : planes)
+      if (glm::dot(glm::vec3(p), center) + p.w < -radius)
+        return false;
+    return true;
+  }
+
+  /**
+   * @brief Whether any of an axis aligned box might be inside.
+   *
+   * @param center the middle of the box
+   * @param extents half the size of the box
+   */
+  bool BoxVisible(glm::vec3 center, glm::vec3 extents) const
+  {
+    for (auto const& p : planes)
+    {
+      glm::vec3 n = glm::vec3(p);
+      if (glm::dot(n, center) + p.w < -glm::dot(glm::abs(n), extents))
+        return false;
+    }
+    return true;
+  }
+} Frustum;
@@ -0,0 +1,260 @@
+#include "pch.h"
+#include "Geometry Arena.h"
+#include "ShaderLog.hpp"
+
+RangeAllocator::RangeAllocator(size_t capacity)
+{
+  Reset(capacity, 0);
+}
+
+bool RangeAllocator::Allocate(size_t size, size_t alignment, size_t& offset)
+{
+  for (auto it = _free.begin(); it != _free.end(); ++it)
+  {
+    size_t start = (it->offset + alignment - 1) / alignment * alignment;
+    size_t end = it->offset + it->size;
+    if (start + size > end)
+      continue;
+    offset = start;
+    _freeSpace -= size;
+    // Whatever the alignment skipped stays free in front of the range
+    arenaRange before = {it->offset, start - it->offset};
+    arenaRange after = {start + size, end - start - size};
+    if (before.size != 0 && after.size != 0)
+    {
+      *it = after;
+      _free.insert(it, before);
+    }
+    else if (before.size != 0)
+      *it = before;
+    else if (after.size != 0)
+      *it = after;
+    else
+      _free.erase(it);
+    return true;
+  }
+  return false;
+}
+
+void RangeAllocator::Free(size_t offset, size_t size)
+{
+  if (size == 0)
+    return;
+  _freeSpace += size;
+  auto next = std::lower_bound(_free.begin(), _free.end(), offset, [](arenaRange const& r, size_t o)
+                               { return r.offset < o; });
+  // Merge into the ranges on either side when they touch
+  bool joinsPrevious = next != _free.begin() && std::prev(next)->offset + std::prev(next)->size == offset;
+  bool joinsNext = next != _free.end() && offset + size == next->offset;
+  if (joinsPrevious && joinsNext)
+  {
+    std::prev(next)->size += size + next->size;
+    _free.erase(next);
+  }
+  else if (joinsPrevious)
+    std::prev(next)->size += size;
+  else if (joinsNext)
+  {
+    next->offset = offset;
+    next->size += size;
+  }
+  else
+    _free.insert(next, {offset, size});
+}
+
+void RangeAllocator::Reset(size_t capacity, size_t used)
+{
+  _capacity = capacity;
+  _freeSpace = capacity - used;
+  _free.clear();
+  if (_freeSpace != 0)
+    _free.push_back({used, _freeSpace});
+}
+
+size_t RangeAllocator::LargestFree() const
+{
+  size_t largest = 0;
+  for (auto const& r : _free)
+    largest = std::max(largest, r.size);
+  return largest;
+}
+
+GeometryArena* GeometryArena::Find(std::vector<vertexAttribute> const& layout, size_t stride)
+{
+  auto same = [&](GeometryArena const* arena)
+  {
+    if (arena->_stride != stride || arena->_layout.size() != layout.size())
+      return false;
+    for (size_t i = 0; i < layout.size(); ++i)
+    {
+      vertexAttribute const& a = arena->_layout[i];
+      vertexAttribute const& b = layout[i];
+      if (a.location != b.location || a.size != b.size || a.type != b.type || a.normalized != b.normalized ||
+          a.integer != b.integer || a.oct != b.oct || a.offset != b.offset)
+        return false;
+    }
+    return true;
+  };
+  for (auto arena : _arenas)
+    if (same(arena))
+      return arena;
+  _arenas.push_back(new GeometryArena(layout, stride));
+  return _arenas.back();
+}
+
+void GeometryArena::Compact()
+{
+  for (auto arena : _arenas)
+  {
+    if (!arena->Sparse())
+      continue;
+    // Keep twice what is in use so the next few meshes do not grow it straight back
+    size_t verticies = arena->_vertexSpace.Capacity() - arena->_vertexSpace.FreeSpace();
+    size_t indexBytes = arena->_indexSpace.Capacity() - arena->_indexSpace.FreeSpace();
+    arena->Repack(std::max(verticies * 2, ArenaInitialVerticies), std::max(indexBytes * 2, ArenaInitialIndexBytes));
+  }
+}
+
+GeometryArena::GeometryArena(std::vector<vertexAttribute> const& layout, size_t stride) : _layout(layout), _stride(stride)
+{
+  glGenVertexArrays(1, &_vao);
+  Repack(ArenaInitialVerticies, ArenaInitialIndexBytes);
+}
+
+uint32_t GeometryArena::Allocate(void const* verticies, size_t vertexCount, void const* indicies, size_t indexBytes)
+{
+  // Reserve whole words so every allocation starts 4 byte aligned, whatever its index type
+  size_t reserved = (indexBytes + sizeof(uint32_t) - 1) / sizeof(uint32_t) * sizeof(uint32_t);
+  if (_vertexSpace.LargestFree() < vertexCount || _indexSpace.LargestFree() < reserved)
+  {
+    // Repacking closes every hole, only grow when that would not be enough
+    auto grow = [](RangeAllocator const& space, size_t size, size_t initial)
+    {
+      if (space.FreeSpace() >= size)
+        return space.Capacity();
+      return std::max({space.Capacity() * 2, space.Capacity() - space.FreeSpace() + size, initial});
+    };
+    Repack(grow(_vertexSpace, vertexCount, ArenaInitialVerticies), grow(_indexSpace, reserved, ArenaInitialIndexBytes));
+  }
+
+  allocation a = {{0, vertexCount}, {0, reserved}, true};
+  auto place = [&]()
+  {
+    if (vertexCount != 0 && !_vertexSpace.Allocate(vertexCount, 1, a.verticies.offset))
+      return false;
+    if (reserved != 0 && !_indexSpace.Allocate(reserved, sizeof(uint32_t), a.indicies.offset))
+    {
+      _vertexSpace.Free(a.verticies.offset, vertexCount);
+      return false;
+    }
+    return true;
+  };
+  if (!place())
+  {
+    // Offsets handed out after a failure would overlap live geometry, grow past what is used instead
+    Repack(std::max(_vertexSpace.Capacity() * 2, _vertexSpace.Capacity() - _vertexSpace.FreeSpace() + vertexCount),
+           std::max(_indexSpace.Capacity() * 2, _indexSpace.Capacity() - _indexSpace.FreeSpace() + reserved));
+    if (!place())
+    {
+      Log(Error, "Geometry arena could not fit", vertexCount, "verticies and", indexBytes, "index bytes");
+      throw std::runtime_error("ORB ERROR: Geometry arena could not fit a mesh");
+    }
+  }
+  if (vertexCount != 0)
+    glNamedBufferSubData(_vertexBuffer, a.verticies.offset * _stride, vertexCount * _stride, verticies);
+  if (indexBytes != 0)
+    glNamedBufferSubData(_indexBuffer, a.indicies.offset, indexBytes, indicies);
+
+  if (!_unused.empty())
+  {
+    uint32_t handle = _unused.back();
+    _unused.pop_back();
+    _allocations[handle] = a;
+    return handle;
+  }
+  _allocations.push_back(a);
+  return static_cast<uint32_t>(_allocations.size() - 1);
+}
+
+void GeometryArena::Free(uint32_t handle)
+{
+  allocation& a = _allocations[handle];
+  if (!a.live)
+    return;
+  _vertexSpace.Free(a.verticies.offset, a.verticies.size);
+  _indexSpace.Free(a.indicies.offset, a.indicies.size);
+  a.live = false;
+  _unused.push_back(handle);
+}
+
+GLint GeometryArena::BaseVertex(uint32_t handle) const
+{
+  return static_cast<GLint>(_allocations[handle].verticies.offset);
+}
+
+size_t GeometryArena::IndexOffset(uint32_t handle) const
+{
+  return _allocations[handle].indicies.offset;
+}
+
+void GeometryArena::Repack(size_t vertexCapacity, size_t indexCapacity)
+{
+  GLuint buffers[2];
+  glCreateBuffers(2, buffers);
+  glNamedBufferStorage(buffers[0], vertexCapacity * _stride, nullptr, GL_DYNAMIC_STORAGE_BIT);
+  glNamedBufferStorage(buffers[1], indexCapacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+  // Copy the live ranges down in the order they were in, so the GPU reads them front to back
+  std::vector<allocation*> live;
+  for (auto& a : _allocations)
+    if (a.live)
+      live.push_back(&a);
+  size_t usedVerticies = 0;
+  std::sort(live.begin(), live.end(), [](allocation const* a, allocation const* b)
+            { return a->verticies.offset < b->verticies.offset; });
+  for (auto a : live)
+  {
+    if (a->verticies.size != 0)
+      glCopyNamedBufferSubData(_vertexBuffer, buffers[0], a->verticies.offset * _stride, usedVerticies * _stride, a->verticies.size * _stride);
+    a->verticies.offset = usedVerticies;
+    usedVerticies += a->verticies.size;
+  }
+  size_t usedIndexBytes = 0;
+  std::sort(live.begin(), live.end(), [](allocation const* a, allocation const* b)
+            { return a->indicies.offset < b->indicies.offset; });
+  for (auto a : live)
+  {
+    if (a->indicies.size != 0)
+      glCopyNamedBufferSubData(_indexBuffer, buffers[1], a->indicies.offset, usedIndexBytes, a->indicies.size);
+    a->indicies.offset = usedIndexBytes;
+    usedIndexBytes += a->indicies.size;
+  }
+
+  if (_vertexBuffer != 0)
+  {
+    Log(Message, "Repacked geometry arena", _vertexSpace.Capacity(), "->", vertexCapacity, "verticies,",
+        _indexSpace.Capacity(), "->", indexCapacity, "index bytes");
+    glDeleteBuffers(1, &_vertexBuffer);
+    glDeleteBuffers(1, &_indexBuffer);
+  }
+  _vertexBuffer = buffers[0];
+  _indexBuffer = buffers[1];
+  _vertexSpace.Reset(vertexCapacity, usedVerticies);
+  _indexSpace.Reset(indexCapacity, usedIndexBytes);
+
+  // The VAO keeps the buffers it was set up with, point it at the new ones
+  glBindVertexArray(_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
+  BindVertexLayout(_layout, _stride);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+}
+
+bool GeometryArena::Sparse() const
+{
+  // Only worth moving everything when it gives back a lot of memory
+  bool verticies = _vertexSpace.Capacity() > ArenaInitialVerticies && _vertexSpace.FreeSpace() * 4 > _vertexSpace.Capacity() * 3;
+  bool indicies = _indexSpace.Capacity() > ArenaInitialIndexBytes && _indexSpace.FreeSpace() * 4 > _indexSpace.Capacity() * 3;
+  return verticies || indicies;
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+// How many verticies and index bytes a new arena starts with
+constexpr size_t ArenaInitialVerticies = 1 << 16;
+constexpr size_t ArenaInitialIndexBytes = 1 << 18;
+
+/**
+ * @brief A piece of a buffer.
+ *
+ * offset - where it starts
+ * size - how long it is
+ */
+typedef struct arenaRange
+{
+  size_t offset;
+  size_t size;
+}arenaRange;
+
+/**
+ * @brief First fit free list over a range of space, it only does the book keeping and never touches GL.
+ *
+ * Freed ranges are merged with their neighbours so the list stays short.
+ */
+class RangeAllocator
+{
+public:
+  RangeAllocator(size_t capacity = 0);
+
+  /**
+   * @brief Take a range out of the free space.
+   *
+   * @param size how much space to take
+   * @param alignment what the offset has to be a multiple of
+   * @param offset where to write the start of the range
+   * @return false if no free range is big enough
+   */
+  bool Allocate(size_t size, size_t alignment, size_t& offset);
+  /**
+   * @brief Give a range back.
+   */
+  void Free(size_t offset, size_t size);
+  /**
+   * @brief Forget every range, everything below used is taken and the rest up to capacity is free.
+   */
+  void Reset(size_t capacity, size_t used);
+
+  size_t Capacity() const { return _capacity; }
+  size_t FreeSpace() const { return _freeSpace; }
+  size_t LargestFree() const;
+
+private:
+  // Sorted by offset
+  std::vector<arenaRange> _free;
+  size_t _capacity = 0;
+  size_t _freeSpace = 0;
+};
+
+/**
+ * @brief One vertex buffer and one index buffer that every mesh with the same vertex layout lives in.
+ *
+ * @details Meshes get a range of each instead of their own buffers, so they all share one VAO and drawing a
+ * different mesh does not rebind anything. Indexed draws use a base vertex, so the indicies are the same as
+ * if the mesh had its own buffer. The buffers are repacked into bigger ones when they fill up and into
+ * smaller ones when most of them is free, which moves meshes, so only ask for offsets when drawing.
+ */
+class GeometryArena
+{
+public:
+  /**
+   * @brief Get the arena for a vertex layout, it is made the first time the layout is asked for.
+   *
+   * @param layout how the verticies are laid out
+   * @param stride the size of one vertex in bytes
+   */
+  static GeometryArena* Find(std::vector<vertexAttribute> const& layout, size_t stride);
+  /**
+   * @brief Repack the arenas that are mostly holes, call when nothing is being drawn.
+   */
+  static void Compact();
+
+  /**
+   * @brief Copy a mesh in.
+   *
+   * @param verticies the verticies, already in the arena's layout
+   * @param vertexCount how many verticies there are
+   * @param indicies the indicies, nullptr if the mesh is not indexed
+   * @param indexBytes the size of the indicies in bytes
+   * @return the allocation, hand it back with Free
+   */
+  uint32_t Allocate(void const* verticies, size_t vertexCount, void const* indicies, size_t indexBytes);
+  void Free(uint32_t allocation);
+
+  /**
+   * @brief Get the first vertex of an allocation, add it to the indicies or pass it as the first vertex.
+   */
+  GLint BaseVertex(uint32_t allocation) const;
+  /**
+   * @brief Get where the indicies of an allocation start in the index buffer, in bytes.
+   */
+  size_t IndexOffset(uint32_t allocation) const;
+
+  GLuint VAO() const { return _vao; }
+  GLuint VertexBuffer() const { return _vertexBuffer; }
+  GLuint IndexBuffer() const { return _indexBuffer; }
+  std::vector<vertexAttribute> const& Layout() const { return _layout; }
+  size_t Stride() const { return _stride; }
+
+private:
+  GeometryArena(std::vector<vertexAttribute> const& layout, size_t stride);
+  ~GeometryArena() = default;
+
+  typedef struct allocation
+  {
+    arenaRange verticies;
+    arenaRange indicies;
+    bool live;
+  }allocation;
+
+  /**
+   * @brief Move every live allocation to the front of new buffers, the old buffers are deleted.
+   *
+   * @param vertexCapacity how many verticies the new vertex buffer holds
+   * @param indexCapacity how many bytes the new index buffer holds
+   */
+  void Repack(size_t vertexCapacity, size_t indexCapacity);
+  // Whether most of the arena is free space
+  bool Sparse() const;
+
+  std::vector<vertexAttribute> _layout;
+  size_t _stride;
+  GLuint _vertexBuffer = 0;
+  GLuint _indexBuffer = 0;
+  GLuint _vao = 0;
+  RangeAllocator _vertexSpace;
+  RangeAllocator _indexSpace;
+  std::vector<allocation> _allocations;
+  // Allocations that were freed, reused before the list grows
+  std::vector<uint32_t> _unused;
+
+  // Arenas live as long as the program, like the GL objects meshes used to leak on exit
+  static inline std::vector<GeometryArena*> _arenas;
+};
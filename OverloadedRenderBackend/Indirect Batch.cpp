@@ -0,0 +1,129 @@
+#include "pch.h"
+#include "Indirect Batch.h"
+#include "Instance Ring.h"
+
+// Where the base instance buffer is bound in the VAO, past anything a vertex layout uses
+constexpr GLuint InstanceBaseBinding = 15;
+// Larger than any instance count, so the instance never moves which index is read
+constexpr GLuint InstanceBaseDivisor = 1u << 30;
+
+IndirectBatch::~IndirectBatch()
+{
+  if (_indicies != 0)
+    glDeleteBuffers(1, &_indicies);
+}
+
+void IndirectBatch::Add(ORB_Mesh const& mesh)
+{
+  if (mesh.State() != MeshState::Ready || mesh.VAO() == 0)
+    return;
+  GLenum indexType = mesh.IndexCount() != 0 ? mesh.IndexType() : 0;
+  drawBucket* bucket = nullptr;
+  for (size_t lod = 0; lod < MaxMeshLods; ++lod)
+  {
+    auto calls = mesh.CallData(static_cast<int>(lod));
+    if (calls.empty())
+      continue;
+    if (bucket == nullptr)
+    {
+      GLuint vao = mesh.VAO();
+      auto found = std::find_if(_buckets.begin(), _buckets.end(), [&](drawBucket const& b)
+                                { return b.vao == vao && b.mode == mesh.DrawMode() && b.indexType == indexType &&
+                                         b.format == mesh.Format() && b.instanceFormat == mesh.InstanceLayout() &&
+                                         b.texture == mesh.Texture(); });
+      if (found == _buckets.end())
+      {
+        _buckets.push_back({.vao = vao,
+                            .mode = mesh.DrawMode(),
+                            .indexType = indexType,
+                            .format = mesh.Format(),
+                            .instanceFormat = mesh.InstanceLayout(),
+                            .texture = mesh.Texture(),
+                            .instances = {},
+                            .instanceCount = 0,
+                            .elements = {},
+                            .arrays = {},
+                            .meshes = {}});
+        found = _buckets.end() - 1;
+      }
+      bucket = &*found;
+      bucket->meshes.push_back(&mesh);
+    }
+
+    meshRange range = mesh.Range(static_cast<int>(lod));
+    GLuint base = bucket->instanceCount;
+    GLuint count = static_cast<GLuint>(mesh.CallCount(static_cast<int>(lod)));
+    bucket->instances.insert(bucket->instances.end(), calls.begin(), calls.end());
+    bucket->instanceCount += count;
+    if (indexType != 0)
+      bucket->elements.push_back({range.count, count, range.first, range.baseVertex, base});
+    else
+      bucket->arrays.push_back({range.count, count, range.first, base});
+  }
+}
+
+void IndirectBatch::Draw(drawBucket const& bucket, InstanceRing& ring)
+{
+  if (bucket.instances.empty())
+    return;
+  ReserveIndicies(bucket.instanceCount);
+
+  size_t instanceBytes = bucket.instances.size();
+  size_t commandBytes = bucket.indexType != 0 ? bucket.elements.size() * sizeof(drawElementsCommand)
+                                              : bucket.arrays.size() * sizeof(drawArraysCommand);
+  // Both have to end up in the same buffer
+  ring.Reserve(instanceBytes + commandBytes, 2);
+  size_t commands = bucket.indexType != 0 ? ring.Copy(bucket.elements.data(), commandBytes)
+                                          : ring.Copy(bucket.arrays.data(), commandBytes);
+  ring.Write(0, bucket.instances.data(), instanceBytes);
+
+  glVertexArrayVertexBuffer(bucket.vao, InstanceBaseBinding, _indicies, 0, sizeof(GLuint));
+  glVertexArrayAttribIFormat(bucket.vao, InstanceBaseAttribute, 1, GL_UNSIGNED_INT, 0);
+  glVertexArrayAttribBinding(bucket.vao, InstanceBaseAttribute, InstanceBaseBinding);
+  glVertexArrayBindingDivisor(bucket.vao, InstanceBaseBinding, InstanceBaseDivisor);
+  glEnableVertexArrayAttrib(bucket.vao, InstanceBaseAttribute);
+
+  glBindVertexArray(bucket.vao);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, ring.Buffer());
+  if (bucket.indexType != 0)
+    glMultiDrawElementsIndirect(bucket.mode, bucket.indexType, reinterpret_cast<void*>(commands),
+                                static_cast<GLsizei>(bucket.elements.size()), 0);
+  else
+    glMultiDrawArraysIndirect(bucket.mode, reinterpret_cast<void*>(commands), static_cast<GLsizei>(bucket.arrays.size()), 0);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  glBindVertexArray(0);
+  for (auto mesh : bucket.meshes)
+    mesh->Fence();
+}
+
+void IndirectBatch::Clear()
+{
+  // Buckets nothing was drawn with belong to meshes that went away
+  std::erase_if(_buckets, [](drawBucket const& b)
+                { return b.instances.empty(); });
+  for (auto& bucket : _buckets)
+  {
+    bucket.instances.clear();
+    bucket.instanceCount = 0;
+    bucket.elements.clear();
+    bucket.arrays.clear();
+    bucket.meshes.clear();
+  }
+  // Draws without the attribute read the current value, which is the base of a plain instanced draw
+  glVertexAttribI4ui(InstanceBaseAttribute, 0, 0, 0, 0);
+}
+
+void IndirectBatch::ReserveIndicies(size_t count)
+{
+  if (count <= _indexCount)
+    return;
+  size_t size = std::max<size_t>(std::bit_ceil(count), 1024);
+  std::vector<GLuint> indicies(size);
+  for (size_t i = 0; i < size; ++i)
+    indicies[i] = static_cast<GLuint>(i);
+  if (_indicies != 0)
+    glDeleteBuffers(1, &_indicies);
+  glCreateBuffers(1, &_indicies);
+  glNamedBufferStorage(_indicies, size * sizeof(GLuint), indicies.data(), 0);
+  _indexCount = size;
+}
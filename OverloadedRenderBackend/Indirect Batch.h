@@ -0,0 +1,106 @@
+#pragma once
+#include <vector>
+#include "Mesh.h"
+
+class InstanceRing;
+
+// The vertex attribute stored shaders read the base instance of a draw from
+constexpr GLuint InstanceBaseAttribute = 7;
+
+/**
+ * @brief One draw of glMultiDrawElementsIndirect, laid out the way GL reads it.
+ */
+typedef struct drawElementsCommand
+{
+  GLuint count;
+  GLuint instanceCount;
+  GLuint firstIndex;
+  GLint baseVertex;
+  GLuint baseInstance;
+}drawElementsCommand;
+
+/**
+ * @brief One draw of glMultiDrawArraysIndirect, laid out the way GL reads it.
+ */
+typedef struct drawArraysCommand
+{
+  GLuint count;
+  GLuint instanceCount;
+  GLuint first;
+  GLuint baseInstance;
+}drawArraysCommand;
+
+/**
+ * @brief Stored calls that can be drawn with one multi draw because they need the same state.
+ *
+ * vao - the VAO the meshes are in
+ * mode - the draw mode
+ * indexType - the type of the indicies, 0 for meshes without indicies
+ * format - how the verticies are stored
+ * instanceFormat - how the calls are stored
+ * texture - the texture to draw with
+ * instances - the calls in the instance format, each draw's calls are together
+ * instanceCount - how many calls there are
+ * elements - the draws of indexed meshes
+ * arrays - the draws of meshes without indicies
+ * meshes - the meshes drawn, to fence the ones that were updated
+ */
+typedef struct drawBucket
+{
+  GLuint vao;
+  GLenum mode;
+  GLenum indexType;
+  VertexFormat format;
+  InstanceFormat instanceFormat;
+  ORB_Texture* texture;
+  std::vector<std::byte> instances;
+  GLuint instanceCount;
+  std::vector<drawElementsCommand> elements;
+  std::vector<drawArraysCommand> arrays;
+  std::vector<ORB_Mesh const*> meshes;
+}drawBucket;
+
+/**
+ * @brief Groups the calls of stored meshes into buckets and draws each bucket with one indirect multi draw.
+ *
+ * @details Every level of detail with calls becomes one command, its base instance is where its calls start in
+ * the bucket's instances. GL 4.5 shaders can not read the base instance, so the stored shaders read it from the
+ * InstanceBaseAttribute: it comes from a buffer that holds each index at that index, with a divisor so large
+ * that the instance never moves it, so every instance of a draw reads the draw's base instance. VAOs without
+ * the attribute read 0.
+ */
+class IndirectBatch
+{
+public:
+  IndirectBatch() = default;
+  ~IndirectBatch();
+  IndirectBatch(IndirectBatch const&) = delete;
+  IndirectBatch& operator=(IndirectBatch const&) = delete;
+
+  /**
+   * @brief Queue every stored call of a mesh.
+   */
+  void Add(ORB_Mesh const& mesh);
+  std::vector<drawBucket>& Buckets() { return _buckets; }
+  /**
+   * @brief Draw a bucket, its texture and vertex format must already be set.
+   *
+   * @param bucket the bucket
+   * @param ring where the instances and commands are written for this frame
+   */
+  void Draw(drawBucket const& bucket, InstanceRing& ring);
+  /**
+   * @brief Empty every bucket, they keep their memory for the next frame.
+   */
+  void Clear();
+
+private:
+  /**
+   * @brief Make sure the index buffer covers every base instance of a bucket.
+   */
+  void ReserveIndicies(size_t count);
+
+  std::vector<drawBucket> _buckets;
+  GLuint _indicies = 0;
+  size_t _indexCount = 0;
+};
@@ -0,0 +1,30 @@
+#include "pch.h"
+#include "Instance Data.h"
+
+affineInstance AffineInstance(glm::mat4 const& matrix, glm::vec3 const& color, int material)
+{
+  glm::mat4 rows = glm::transpose(matrix);
+  return {{rows[0], rows[1], rows[2]}, color, material};
+}
+
+flatInstance FlatInstance(glm::mat4 const& matrix, glm::vec3 const& color, int material)
+{
+  glm::vec2 x = matrix[0];
+  glm::vec2 y = matrix[1];
+  // A mirrored matrix keeps the direction of x and flips y
+  float sign = x.x * y.y - x.y * y.x < 0 ? -1.f : 1.f;
+  return {glm::vec2(matrix[3]), {glm::length(x), glm::length(y) * sign}, std::atan2(x.y, x.x), matrix[3].z,
+          glm::packUnorm4x8(glm::vec4(color, 1)), material};
+}
+
+glm::mat4 InstanceMatrix(affineInstance const& instance)
+{
+  return glm::transpose(glm::mat4(instance.rows[0], instance.rows[1], instance.rows[2], glm::vec4(0, 0, 0, 1)));
+}
+
+glm::mat4 InstanceMatrix(flatInstance const& instance)
+{
+  glm::mat4 matrix = glm::translate(glm::identity<glm::mat4>(), glm::vec3(instance.position, instance.depth));
+  matrix = glm::rotate(matrix, instance.rotation, glm::vec3(0, 0, 1));
+  return glm::scale(matrix, glm::vec3(instance.scale, 1));
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <glm.hpp>
+#include <cstdint>
+
+/**
+ * @brief How a mesh's stored calls are sent to the GPU.
+ *
+ * Affine - the top 3 rows of the object matrix, a color and a material, 64 bytes
+ * Flat - a position, scale, rotation around z and depth, an 8 bit color and a material, 32 bytes. Only
+ *        matrices that move, turn around z and scale keep their shape, colors are clamped to 0-1
+ */
+enum class InstanceFormat : int
+{
+  Affine,
+  Flat
+};
+
+/**
+ * @brief One stored call in the Affine format, laid out the way RenderBuffer reads it.
+ *
+ * The rows are the object matrix transposed, the bottom row of an affine matrix is always 0 0 0 1. The normal
+ * matrix is worked out from them in the vertex shader.
+ */
+typedef struct affineInstance
+{
+  glm::vec4 rows[3];
+  glm::vec3 color;
+  int materialID;
+}affineInstance;
+
+/**
+ * @brief One stored call in the Flat format, laid out the way FlatRenderBuffer reads it.
+ *
+ * color - the color packed as 8 bit unsigned normalized RGBA
+ */
+typedef struct flatInstance
+{
+  glm::vec2 position;
+  glm::vec2 scale;
+  float rotation;
+  float depth;
+  uint32_t color;
+  int materialID;
+}flatInstance;
+
+static_assert(sizeof(affineInstance) == 64, "affineInstance has to match the std430 layout of the shaders");
+static_assert(sizeof(flatInstance) == 32, "flatInstance has to match the std430 layout of the shaders");
+
+affineInstance AffineInstance(glm::mat4 const& matrix, glm::vec3 const& color, int material);
+flatInstance FlatInstance(glm::mat4 const& matrix, glm::vec3 const& color, int material);
+/**
+ * @brief Rebuild the object matrix of an instance, for culling.
+ */
+glm::mat4 InstanceMatrix(affineInstance const& instance);
+glm::mat4 InstanceMatrix(flatInstance const& instance);
@@ -0,0 +1,107 @@
+#include "pch.h"
+#include "Instance Ring.h"
+#include "ShaderLog.hpp"
+
+InstanceRing::~InstanceRing()
+{
+  for (auto fence : _fences)
+    if (fence)
+      glDeleteSync(fence);
+  if (_buffer == 0)
+    return;
+  glUnmapNamedBuffer(_buffer);
+  glDeleteBuffers(1, &_buffer);
+}
+
+void InstanceRing::BeginFrame()
+{
+  _region = (_region + 1) % InstanceRingRegions;
+  Wait(_region);
+  _used = 0;
+}
+
+void InstanceRing::Reserve(size_t bytes, size_t blocks)
+{
+  if (_buffer == 0)
+    Create(InstanceRingInitialBytes);
+  // Every block can lose up to an alignment to padding
+  size_t needed = bytes + blocks * _alignment;
+  if (_used + needed > _regionBytes)
+    Create(std::max(_regionBytes * 2, needed * 2));
+}
+
+size_t InstanceRing::Copy(void const* data, size_t bytes)
+{
+  if (_buffer == 0)
+    Create(InstanceRingInitialBytes);
+  // Ranges have to start on the binding alignment
+  size_t offset = (_used + _alignment - 1) / _alignment * _alignment;
+  if (offset + bytes > _regionBytes)
+  {
+    Create(std::max(_regionBytes * 2, bytes * 2));
+    offset = 0;
+  }
+  size_t start = _region * _regionBytes + offset;
+  std::memcpy(_mapped + start, data, bytes);
+  _used = offset + bytes;
+  return start;
+}
+
+void InstanceRing::Write(GLuint binding, void const* data, size_t bytes)
+{
+  if (bytes == 0)
+    return;
+  size_t start = Copy(data, bytes);
+  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, _buffer, start, bytes);
+}
+
+void InstanceRing::EndFrame()
+{
+  if (_buffer == 0)
+    return;
+  if (_fences[_region])
+    glDeleteSync(_fences[_region]);
+  _fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void InstanceRing::Create(size_t regionBytes)
+{
+  GLint alignment = 1;
+  glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  // Draw commands only need 4 bytes, but they share the buffer
+  _alignment = std::max<size_t>(alignment, sizeof(GLuint));
+  regionBytes = (regionBytes + _alignment - 1) / _alignment * _alignment;
+
+  if (_buffer != 0)
+  {
+    Log(Message, "Grew instance ring", _regionBytes, "->", regionBytes, "bytes per frame");
+    // Draws already issued keep the old buffer alive until they are done with it
+    glUnmapNamedBuffer(_buffer);
+    glDeleteBuffers(1, &_buffer);
+    for (auto& fence : _fences)
+    {
+      if (fence)
+        glDeleteSync(fence);
+      fence = nullptr;
+    }
+  }
+  // Coherent, so what is copied in needs no flush before the draw
+  GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  glCreateBuffers(1, &_buffer);
+  glNamedBufferStorage(_buffer, regionBytes * InstanceRingRegions, nullptr, flags);
+  _mapped = static_cast<char*>(glMapNamedBufferRange(_buffer, 0, regionBytes * InstanceRingRegions, flags));
+  _regionBytes = regionBytes;
+  _used = 0;
+}
+
+void InstanceRing::Wait(size_t region)
+{
+  GLsync fence = _fences[region];
+  if (fence == nullptr)
+    return;
+  GLenum wait = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+  while (wait == GL_TIMEOUT_EXPIRED)
+    wait = glClientWaitSync(fence, 0, 1000000);
+  glDeleteSync(fence);
+  _fences[region] = nullptr;
+}
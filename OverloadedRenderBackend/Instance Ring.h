@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+
+// How many frames of instance data a ring holds, the GPU can be reading two while the third is written
+constexpr size_t InstanceRingRegions = 3;
+// How many bytes each frame gets to start with
+constexpr size_t InstanceRingInitialBytes = 1 << 16;
+
+/**
+ * @brief Per instance data and draw commands for stored rendering, streamed through one persistently mapped buffer.
+ *
+ * @details The buffer is split into a region per frame. Blocks written during a frame go one after another
+ * into that frame's region and are bound as a range, so the instance index a shader reads starts at 0 for every
+ * block the same way a base instance would move it. A fence at the end of the frame says when the region can
+ * be written again. A frame that needs more space grows the buffer, the old one is released once the GPU is done.
+ */
+class InstanceRing
+{
+public:
+  InstanceRing() = default;
+  ~InstanceRing();
+  InstanceRing(InstanceRing const&) = delete;
+  InstanceRing& operator=(InstanceRing const&) = delete;
+
+  /**
+   * @brief Move on to the next region, waiting if the GPU still reads it.
+   */
+  void BeginFrame();
+  /**
+   * @brief Make sure the next blocks fit without growing, so blocks bound before them stay in the same buffer.
+   *
+   * @param bytes how many bytes the blocks take together
+   * @param blocks how many blocks there are
+   */
+  void Reserve(size_t bytes, size_t blocks);
+  /**
+   * @brief Copy a block in after the last one.
+   *
+   * @return where the block starts in Buffer(), in bytes
+   */
+  size_t Copy(void const* data, size_t bytes);
+  /**
+   * @brief Copy a block in after the last one and bind it as a shader storage range.
+   *
+   * @param binding the shader storage binding to bind the block to
+   * @param data the block
+   * @param bytes the size of the block
+   */
+  void Write(GLuint binding, void const* data, size_t bytes);
+  /**
+   * @brief Mark the region as read by everything drawn this frame.
+   */
+  void EndFrame();
+
+  GLuint Buffer() const { return _buffer; }
+
+private:
+  /**
+   * @brief Make a new buffer, the current one is released.
+   *
+   * @param regionBytes how many bytes each region holds
+   */
+  void Create(size_t regionBytes);
+  void Wait(size_t region);
+
+  GLuint _buffer = 0;
+  char* _mapped = nullptr;
+  size_t _regionBytes = 0;
+  size_t _alignment = 1;
+  size_t _region = 0;
+  // How much of the region this frame has written
+  size_t _used = 0;
+  GLsync _fences[InstanceRingRegions] = {};
+};
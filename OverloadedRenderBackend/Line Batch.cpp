@@ -0,0 +1,56 @@
+#include "pch.h"
+#include "Line Batch.h"
+
+// Where the line stage reads the points from, the stored stages use 0 and 1
+constexpr GLuint LinePointBinding = 2;
+// A quad and a join triangle
+constexpr GLsizei VerticiesPerSegment = 9;
+
+LineBatch::~LineBatch()
+{
+  if (_vao == 0)
+    return;
+  glDeleteBuffers(1, &_buffer);
+  glDeleteVertexArrays(1, &_vao);
+}
+
+void LineBatch::Add(std::span<glm::vec3 const> points, glm::vec4 const& color, float thickness, LineJoin join, unsigned int depth)
+{
+  if (points.size() < 2)
+    return;
+  if (_runs.empty() || _runs.back().depth != depth)
+    _runs.push_back({depth, _points.size(), 0});
+  _runs.back().count += points.size();
+
+  uint32_t flags = join == LineJoin::Bevel ? LinePointBevel : 0;
+  for (auto const& p : points)
+    _points.push_back({glm::vec4(p, 1), color, thickness, flags, {}});
+  _points.back().flags |= LinePointEnd;
+}
+
+void LineBatch::Upload()
+{
+  if (_vao == 0)
+  {
+    glCreateBuffers(1, &_buffer);
+    // The stage has no vertex inputs, but something has to be bound to draw
+    glCreateVertexArrays(1, &_vao);
+  }
+  glNamedBufferData(_buffer, _points.size() * sizeof(linePoint), _points.data(), GL_STREAM_DRAW);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LinePointBinding, _buffer);
+}
+
+void LineBatch::Draw(lineRun const& run) const
+{
+  // The last point of a run always ends a line, so the segment it would start draws nothing
+  glBindVertexArray(_vao);
+  glDrawArrays(GL_TRIANGLES, static_cast<GLint>(run.first * VerticiesPerSegment),
+               static_cast<GLsizei>(run.count * VerticiesPerSegment));
+  glBindVertexArray(0);
+}
+
+void LineBatch::Clear()
+{
+  _points.clear();
+  _runs.clear();
+}
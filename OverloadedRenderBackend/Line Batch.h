@@ -0,0 +1,98 @@
+#pragma once
+#include <vector>
+#include <span>
+
+/**
+ * @brief How two segments of a polyline meet.
+ *
+ * Miter - the edges are extended until they meet, sharp corners fall back to a bevel
+ * Bevel - the corner is cut off
+ */
+enum class LineJoin
+{
+  Miter,
+  Bevel,
+};
+
+// Flags a line point can have, they match the ones in lines.vert
+constexpr uint32_t LinePointEnd = 1;
+constexpr uint32_t LinePointBevel = 2;
+
+/**
+ * @brief One point of a line as the line stage reads it, laid out for std430.
+ *
+ * position - where the point is in the world
+ * color - the color of the line at this point
+ * thickness - how wide the line is here in pixels
+ * flags - LinePointEnd on the last point of a line, LinePointBevel if the join here is bevelled
+ */
+typedef struct linePoint
+{
+  glm::vec4 position;
+  glm::vec4 color;
+  float thickness;
+  uint32_t flags;
+  float padding[2];
+}linePoint;
+
+/**
+ * @brief Lines in a row that go to the same layer.
+ *
+ * depth - the layer the lines were drawn to
+ * first - the first point of the run
+ * count - how many points there are
+ */
+typedef struct lineRun
+{
+  unsigned int depth;
+  size_t first;
+  size_t count;
+}lineRun;
+
+/**
+ * @brief Collects lines and polylines so all of them are drawn from one buffer.
+ *
+ * @details Only the points are uploaded. The line stage turns every segment into a quad of the right thickness and
+ * a triangle for the join on the GPU, so a segment costs one point no matter how thick it is.
+ */
+class LineBatch
+{
+public:
+  LineBatch() = default;
+  ~LineBatch();
+  LineBatch(LineBatch const&) = delete;
+  LineBatch& operator=(LineBatch const&) = delete;
+
+  /**
+   * @brief Queue a line through every point, lines with less than 2 points are ignored.
+   *
+   * @param points the points in order
+   * @param color the color of the whole line
+   * @param thickness the width of the line in pixels
+   * @param join how the segments meet
+   * @param depth the layer to draw it to
+   */
+  void Add(std::span<glm::vec3 const> points, glm::vec4 const& color, float thickness, LineJoin join, unsigned int depth);
+
+  bool Empty() const { return _runs.empty(); }
+  std::vector<lineRun> const& Runs() const { return _runs; }
+
+  /**
+   * @brief Send every queued point to the GPU and bind it for the line stage, call once before drawing the runs.
+   */
+  void Upload();
+  /**
+   * @brief Draw one run, the line stage must be active with its uniforms written.
+   */
+  void Draw(lineRun const& run) const;
+  /**
+   * @brief Forget every queued line.
+   */
+  void Clear();
+
+private:
+  std::vector<linePoint> _points;
+  std::vector<lineRun> _runs;
+  GLuint _vao = 0;
+  GLuint _buffer = 0;
+};
@@ -0,0 +1,102 @@
+#include "pch.h"
+#include "Mapped File.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(std::string const& path) : _path(path)
+{
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    throw std::runtime_error("Could not open file: " + path);
+  LARGE_INTEGER size;
+  GetFileSizeEx(file, &size);
+  _size = static_cast<size_t>(size.QuadPart);
+  _file = file;
+  if (_size == 0)
+  {
+    _data = "";
+    return;
+  }
+  _mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (_mapping != nullptr)
+    _data = static_cast<char const*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+  int file = open(path.c_str(), O_RDONLY);
+  if (file == -1)
+    throw std::runtime_error("Could not open file: " + path);
+  struct stat info;
+  fstat(file, &info);
+  _size = static_cast<size_t>(info.st_size);
+  if (_size == 0)
+  {
+    close(file);
+    _data = "";
+    return;
+  }
+  void* view = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+  // The mapping holds its own reference to the file
+  close(file);
+  if (view != MAP_FAILED)
+  {
+    madvise(view, _size, MADV_SEQUENTIAL);
+    _data = static_cast<char const*>(view);
+  }
+#endif
+  if (_data == nullptr)
+  {
+    Close();
+    throw std::runtime_error("Could not map file: " + path);
+  }
+}
+
+MappedFile::~MappedFile()
+{
+  Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+  *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+  if (this == &other)
+    return *this;
+  Close();
+  std::swap(_data, other._data);
+  std::swap(_size, other._size);
+  std::swap(_path, other._path);
+#ifdef _WIN32
+  std::swap(_file, other._file);
+  std::swap(_mapping, other._mapping);
+#endif
+  return *this;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+  if (_data != nullptr && _size != 0)
+    UnmapViewOfFile(_data);
+  if (_mapping != nullptr)
+    CloseHandle(_mapping);
+  if (_file != nullptr)
+    CloseHandle(_file);
+  _mapping = nullptr;
+  _file = nullptr;
+#else
+  if (_data != nullptr && _size != 0)
+    munmap(const_cast<char*>(_data), _size);
+#endif
+  _data = nullptr;
+  _size = 0;
+}
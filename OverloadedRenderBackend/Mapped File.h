@@ -0,0 +1,49 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+/**
+ * @brief Read only view of a whole file mapped into memory.
+ *
+ * The mapping lives as long as the object, moving it hands the view over
+ * without touching the file again.
+ */
+class MappedFile
+{
+public:
+  MappedFile() = default;
+  /**
+   * @brief Map a file.
+   *
+   * @param path the file to map
+   * @details throws std::runtime_error if the file can not be opened or mapped
+   */
+  MappedFile(std::string const& path);
+  ~MappedFile();
+
+  MappedFile(MappedFile const&) = delete;
+  MappedFile& operator=(MappedFile const&) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  /**
+   * @brief Unmap the file, the view is invalid afterwards.
+   */
+  void Close();
+
+  bool Open() const { return _data != nullptr; }
+  char const* Data() const { return _data; }
+  size_t Size() const { return _size; }
+  std::string_view View() const { return { _data, _size }; }
+  std::string const& Path() const { return _path; }
+
+private:
+  char const* _data = nullptr;
+  size_t _size = 0;
+  std::string _path;
+#ifdef _WIN32
+  void* _file = nullptr;
+  void* _mapping = nullptr;
+#endif
+};
@@ -0,0 +1,68 @@
+#include "pch.h"
+#include "Material Table.h"
+
+// How many materials the buffer holds to start with
+constexpr size_t MaterialTableInitialCapacity = 64;
+
+MaterialTable::~MaterialTable()
+{
+  if (_buffer != 0)
+    glDeleteBuffers(1, &_buffer);
+}
+
+int MaterialTable::Intern(glm::vec3 const& diff, glm::vec3 const& spec, float specExp)
+{
+  MaterialInfo material = {.diff = diff, .buffer = 0, .spec = spec, .specExp = specExp};
+  std::lock_guard guard(_lock);
+  auto [it, added] = _ids.try_emplace(material, static_cast<int>(_materials.size()));
+  if (added)
+    _materials.push_back(material);
+  return it->second;
+}
+
+size_t MaterialTable::size() const
+{
+  std::lock_guard guard(_lock);
+  return _materials.size();
+}
+
+void MaterialTable::Upload(GLuint binding)
+{
+  if (_buffer == 0 || _materials.size() > _capacity)
+  {
+    size_t capacity = std::max(std::bit_ceil(_materials.size()), MaterialTableInitialCapacity);
+    GLuint buffer;
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, capacity * sizeof(MaterialInfo), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    // What was already sent moves over on the GPU
+    if (_buffer != 0)
+    {
+      glCopyNamedBufferSubData(_buffer, buffer, 0, 0, _dirtyFirst * sizeof(MaterialInfo));
+      glDeleteBuffers(1, &_buffer);
+    }
+    _buffer = buffer;
+    _capacity = capacity;
+  }
+  if (_dirtyFirst < _materials.size())
+  {
+    glNamedBufferSubData(_buffer, _dirtyFirst * sizeof(MaterialInfo), (_materials.size() - _dirtyFirst) * sizeof(MaterialInfo),
+                         _materials.data() + _dirtyFirst);
+    _dirtyFirst = _materials.size();
+  }
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, _buffer);
+}
+
+size_t MaterialTable::MaterialHash::operator()(MaterialInfo const& m) const
+{
+  // std::hash gives 0 and -0 the same hash, so equal materials always hash the same
+  std::hash<float> hash;
+  size_t seed = 0;
+  for (float value : {m.diff.x, m.diff.y, m.diff.z, m.spec.x, m.spec.y, m.spec.z, m.specExp})
+    seed ^= hash(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  return seed;
+}
+
+bool MaterialTable::MaterialEqual::operator()(MaterialInfo const& a, MaterialInfo const& b) const
+{
+  return a.diff == b.diff && a.spec == b.spec && a.specExp == b.specExp;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <glad.h>
+#include <glm.hpp>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+/**
+ * @brief One material, laid out the way MaterialBuffer reads it.
+ */
+typedef struct MaterialInfo {
+  glm::vec3 diff;
+  float buffer;
+  glm::vec3 spec;
+  float specExp;
+}MaterialInfo;
+
+/**
+ * @brief Every material used by stored rendering, each keeps the id it was first given.
+ *
+ * @details Materials are found by a hash of their values, so setting one costs the same however many there are.
+ * The table owns the buffer the shaders read them from and only sends the materials added since the last
+ * upload, most frames add none and send nothing.
+ */
+class MaterialTable
+{
+public:
+  MaterialTable() = default;
+  ~MaterialTable();
+  MaterialTable(MaterialTable const&) = delete;
+  MaterialTable& operator=(MaterialTable const&) = delete;
+
+  /**
+   * @brief Get the id of a material, adding it if it is new. Safe to call from any thread.
+   */
+  int Intern(glm::vec3 const& diff, glm::vec3 const& spec, float specExp);
+  MaterialInfo const& operator[](size_t id) const { return _materials[id]; }
+  size_t size() const;
+
+  /**
+   * @brief Send what changed since the last upload and bind the buffer for the shaders.
+   *
+   * @param binding the shader storage binding to bind it to
+   */
+  void Upload(GLuint binding);
+
+private:
+  struct MaterialHash
+  {
+    size_t operator()(MaterialInfo const& m) const;
+  };
+  struct MaterialEqual
+  {
+    bool operator()(MaterialInfo const& a, MaterialInfo const& b) const;
+  };
+
+  std::vector<MaterialInfo> _materials;
+  std::unordered_map<MaterialInfo, int, MaterialHash, MaterialEqual> _ids;
+  // Materials from here on are not in the buffer yet
+  size_t _dirtyFirst = 0;
+  GLuint _buffer = 0;
+  size_t _capacity = 0;
+  // Stored draws can set materials from any thread
+  mutable std::mutex _lock;
+};
@@ -0,0 +1,129 @@
+#include "pch.h"
+#include "Mesh Binary.h"
+#include "Mesh.h"
+#include "TexturedMesh.h"
+#include "Wermal Reader.h"
+#include "ShaderLog.hpp"
+#include <fstream>
+#include <cstring>
+
+MeshFileHeader const& ReadMeshHeader(MappedFile const& file)
+{
+  if (file.Size() < sizeof(MeshFileHeader))
+    throw std::runtime_error("Mesh file too small: " + file.Path());
+  MeshFileHeader const& header = *reinterpret_cast<MeshFileHeader const*>(file.Data());
+  if (std::memcmp(header.magic, MeshFileMagic, sizeof(MeshFileMagic)) != 0)
+    throw std::runtime_error("Not a binary mesh file: " + file.Path());
+  if (header.version != MeshFileVersion)
+    throw std::runtime_error("Unsupported mesh file version: " + file.Path());
+  if (header.vertexSize != sizeof(Vertex))
+    throw std::runtime_error("Mesh file vertex layout does not match: " + file.Path());
+  if (header.vertexOffset % alignof(Vertex) != 0 || sizeof(MeshFileHeader) + header.textureLength > header.vertexOffset ||
+      header.vertexOffset > file.Size() || header.vertexCount > (file.Size() - header.vertexOffset) / sizeof(Vertex))
+    throw std::runtime_error("Mesh file is truncated or corrupt: " + file.Path());
+  if (header.indexCount != 0 && (header.indexOffset % alignof(uint32_t) != 0 || header.indexOffset > file.Size() ||
+                                 header.indexCount > (file.Size() - header.indexOffset) / sizeof(uint32_t)))
+    throw std::runtime_error("Mesh file is truncated or corrupt: " + file.Path());
+  if (header.lodCount != 0 && (header.lodCount > MaxMeshLods || header.lodOffset % alignof(meshLod) != 0 || header.lodOffset > file.Size() ||
+                               header.lodCount > (file.Size() - header.lodOffset) / sizeof(meshLod)))
+    throw std::runtime_error("Mesh file is truncated or corrupt: " + file.Path());
+  return header;
+}
+
+std::string_view ReadMeshTexture(MappedFile const& file)
+{
+  MeshFileHeader const& header = ReadMeshHeader(file);
+  return { file.Data() + sizeof(MeshFileHeader), header.textureLength };
+}
+
+std::span<const Vertex> ReadMeshVerticies(MappedFile const& file)
+{
+  MeshFileHeader const& header = ReadMeshHeader(file);
+  return { reinterpret_cast<Vertex const*>(file.Data() + header.vertexOffset), static_cast<size_t>(header.vertexCount) };
+}
+
+std::span<const uint32_t> ReadMeshIndicies(MappedFile const& file)
+{
+  MeshFileHeader const& header = ReadMeshHeader(file);
+  if (header.indexCount == 0)
+    return {};
+  return { reinterpret_cast<uint32_t const*>(file.Data() + header.indexOffset), static_cast<size_t>(header.indexCount) };
+}
+
+std::span<const meshLod> ReadMeshLods(MappedFile const& file)
+{
+  MeshFileHeader const& header = ReadMeshHeader(file);
+  if (header.lodCount == 0)
+    return {};
+  std::span<const meshLod> lods = { reinterpret_cast<meshLod const*>(file.Data() + header.lodOffset), static_cast<size_t>(header.lodCount) };
+  for (auto const& lod : lods)
+    if (lod.offset > header.indexCount || lod.count > header.indexCount - lod.offset)
+      throw std::runtime_error("Mesh file is truncated or corrupt: " + file.Path());
+  return lods;
+}
+
+void WriteMeshFile(std::string const& path, uint32_t drawMode, std::span<const Vertex> verticies, std::span<const uint32_t> indicies, std::span<const meshLod> lods, std::string_view texture)
+{
+  MeshFileHeader header = {};
+  std::memcpy(header.magic, MeshFileMagic, sizeof(MeshFileMagic));
+  header.version = MeshFileVersion;
+  header.drawMode = drawMode;
+  header.vertexSize = sizeof(Vertex);
+  header.vertexCount = verticies.size();
+  header.textureLength = static_cast<uint32_t>(texture.size());
+  // Round up so the blob can be read in place as Vertex
+  header.vertexOffset = (sizeof(MeshFileHeader) + texture.size() + 15) & ~uint64_t(15);
+  header.indexCount = indicies.size();
+  header.indexOffset = indicies.empty() ? 0 : header.vertexOffset + verticies.size_bytes();
+  header.lodCount = lods.size();
+  header.lodOffset = lods.empty() ? 0 : header.vertexOffset + verticies.size_bytes() + indicies.size_bytes();
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open())
+    throw std::runtime_error("Could not open file for writing: " + path);
+  const char padding[16] = {};
+  out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+  out.write(texture.data(), texture.size());
+  out.write(padding, header.vertexOffset - sizeof(MeshFileHeader) - texture.size());
+  out.write(reinterpret_cast<char const*>(verticies.data()), verticies.size_bytes());
+  out.write(reinterpret_cast<char const*>(indicies.data()), indicies.size_bytes());
+  out.write(reinterpret_cast<char const*>(lods.data()), lods.size_bytes());
+  if (!out.good())
+    throw std::runtime_error("Failed writing mesh file: " + path);
+}
+
+bool ConvertMeshFile(std::string const& source, std::string const& destination)
+{
+  try
+  {
+    std::string token;
+    if (GetFileType(source.substr(source.rfind('.'))) == fileTypes::obj)
+      token = "<texturedmesh>";
+    else
+    {
+      WermalReader s(source);
+      token = makeLowerCase(std::string(s.ReadToken()));
+    }
+    if (token == "<texturedmesh>")
+    {
+      TexturedMesh m;
+      m.Load(source);
+      WriteMeshFile(destination, m.DrawMode(), m.Verticies(), m.Indicies(), m.Lods(), m.TexturePath());
+    }
+    else if (token == "<mesh>")
+    {
+      ORB_Mesh m;
+      m.Load(source);
+      WriteMeshFile(destination, m.DrawMode(), m.Verticies(), m.Indicies(), m.Lods());
+    }
+    else
+      throw std::runtime_error("Unknown mesh type " + token);
+  }
+  catch (std::exception const& e)
+  {
+    Log(Error, "Failed to convert mesh", source + ":", e.what());
+    return false;
+  }
+  Log(Message, "Converted mesh", source, "to", destination);
+  return true;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include "Vertex.h"
+#include "Mapped File.h"
+#include "Mesh Optimizer.h"
+
+// Binary mesh container (.orbm)
+// ----------------------------------
+// [MeshFileHeader][texture path, textureLength bytes][padding to vertexOffset][vertexCount * Vertex][indexCount * uint32_t][lodCount * meshLod]
+//
+// The vertex blob is the in memory Vertex layout with normals already calculated, so a mapped
+// file can be handed straight to the GPU without parsing anything. Meshes that were welded
+// keep their indicies right after the verticies, levels of detail are ranges of those indicies.
+
+constexpr char MeshFileMagic[4] = { 'O', 'R', 'B', 'M' };
+constexpr uint32_t MeshFileVersion = 3;
+
+typedef struct MeshFileHeader
+{
+  char magic[4];
+  uint32_t version;
+  uint32_t drawMode;
+  // sizeof(Vertex) when the file was written, files from a different layout are rejected
+  uint32_t vertexSize;
+  uint64_t vertexCount;
+  // offset of the vertex blob from the start of the file, always 16 byte aligned
+  uint64_t vertexOffset;
+  // length of the texture path that follows the header, 0 for untextured meshes
+  uint32_t textureLength;
+  uint32_t flags;
+  // 0 for meshes drawn without indicies
+  uint64_t indexCount;
+  // offset of the index blob from the start of the file
+  uint64_t indexOffset;
+  // 0 for meshes without levels of detail, otherwise the first level is the full mesh
+  uint64_t lodCount;
+  // offset of the level of detail table from the start of the file
+  uint64_t lodOffset;
+}MeshFileHeader;
+
+/**
+ * @brief Validate and get the header of a mapped mesh file.
+ *
+ * @param file the mapped file
+ * @return the header, throws std::runtime_error if the file is not a valid mesh file
+ */
+MeshFileHeader const& ReadMeshHeader(MappedFile const& file);
+/**
+ * @brief Get the texture path stored in a mapped mesh file.
+ *
+ * @param file the mapped file
+ * @return the path, empty for untextured meshes
+ */
+std::string_view ReadMeshTexture(MappedFile const& file);
+/**
+ * @brief Get the vertex blob of a mapped mesh file.
+ *
+ * @param file the mapped file
+ * @return view into the mapping, only valid while the file stays mapped
+ */
+std::span<const Vertex> ReadMeshVerticies(MappedFile const& file);
+/**
+ * @brief Get the index blob of a mapped mesh file.
+ *
+ * @param file the mapped file
+ * @return view into the mapping, empty if the mesh has no indicies
+ */
+std::span<const uint32_t> ReadMeshIndicies(MappedFile const& file);
+/**
+ * @brief Get the levels of detail of a mapped mesh file.
+ *
+ * @param file the mapped file
+ * @return view into the mapping, empty if the mesh has no levels of detail
+ */
+std::span<const meshLod> ReadMeshLods(MappedFile const& file);
+
+/**
+ * @brief Write a binary mesh file.
+ *
+ * @param path the file to write
+ * @param drawMode the GL draw mode of the mesh
+ * @param verticies the verticies, normals should already be calculated
+ * @param indicies the indicies, empty if the mesh is drawn without them
+ * @param lods the levels of detail, ranges of indicies
+ * @param texture the texture path for textured meshes
+ */
+void WriteMeshFile(std::string const& path, uint32_t drawMode, std::span<const Vertex> verticies, std::span<const uint32_t> indicies, std::span<const meshLod> lods, std::string_view texture = {});
+
+/**
+ * @brief Convert a text mesh (<mesh> or <texturedmesh>) or an OBJ into a binary mesh file.
+ *
+ * @param source the .dat or .obj file to read
+ * @param destination the .orbm file to write
+ * @return whether the conversion succeeded
+ */
+bool ConvertMeshFile(std::string const& source, std::string const& destination);
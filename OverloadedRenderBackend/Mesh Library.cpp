@@ -2,6 +2,12 @@
 #include "Mesh Library.h"
 #include "Mesh.h"
 #include "TexturedMesh.h"
+#include "Mesh Binary.h"
+#include "Stream.h"
+#include "ShaderLog.hpp"
+#include "File Watcher.h"
+#include "Submission Context.h"
+#include <filesystem>
 
 MeshLibrary *MeshLibrary::Instance()
 {
@@ -19,20 +25,12 @@ ORB_Mesh *MeshLibrary::CreateMesh()
 
 ORB_Mesh *MeshLibrary::CreateMesh(std::string s)
 {
-  ORB_Mesh *m = new ORB_Mesh();
-  m->Read(s);
-  m->path = s;
-  _meshes.push_back(m);
-  return m;
+  return Load(s, false, false);
 }
 
 ORB_Mesh *MeshLibrary::CreateMesh(const char *c)
 {
-  ORB_Mesh *m = new ORB_Mesh();
-  m->Read(c);
-  m->path = c;
-  _meshes.push_back(m);
-  return m;
+  return Load(c, false, false);
 }
 
 ORB_Mesh *MeshLibrary::CreateTexMesh()
@@ -44,43 +42,266 @@ ORB_Mesh *MeshLibrary::CreateTexMesh()
 
 ORB_Mesh *MeshLibrary::CreateTexMesh(std::string c)
 {
-  ORB_Mesh *m = new TexturedMesh();
-  m->Read(c);
-  m->path = c;
-  _meshes.push_back(m);
-  return m;
+  return Load(c, true, false);
 }
 
 ORB_Mesh *MeshLibrary::CreateTexMesh(const char *c)
 {
-  ORB_Mesh *m = new TexturedMesh();
-  m->Read(c);
-  m->path = c;
+  return Load(c, true, false);
+}
+
+ORB_Mesh *MeshLibrary::CreateMeshAsync(std::string s)
+{
+  return Load(s, false, true);
+}
+
+ORB_Mesh *MeshLibrary::CreateTexMeshAsync(std::string s)
+{
+  return Load(s, true, true);
+}
+
+void MeshLibrary::SetCacheDirectory(std::string directory)
+{
+  if (!directory.empty())
+    std::filesystem::create_directories(directory);
+  _cacheDirectory = directory;
+}
+
+// FNV-1a over 8 byte words, only used to name cache files so it just has to be fast and spread well
+static uint64_t ContentHash(std::string_view data, bool textured)
+{
+  constexpr uint64_t prime = 0x100000001b3;
+  uint64_t hash = 0xcbf29ce484222325 ^ (textured ? 0x9e3779b97f4a7c15 : 0);
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= data.size(); i += sizeof(uint64_t))
+  {
+    uint64_t word;
+    std::memcpy(&word, data.data() + i, sizeof(word));
+    hash = (hash ^ word) * prime;
+  }
+  for (; i < data.size(); ++i)
+    hash = (hash ^ static_cast<unsigned char>(data[i])) * prime;
+  return hash ^ data.size();
+}
+
+// Load a mesh, going through the cache directory for anything that has to be parsed
+static void LoadCached(ORB_Mesh *m, std::string const &path, bool textured, std::string const &cache)
+{
+  if (cache.empty() || GetFileType(path.substr(path.rfind('.'))) == fileTypes::binary)
+  {
+    m->Load(path);
+    return;
+  }
+
+  std::string cached;
+  {
+    MappedFile source(path);
+    // Optimized meshes and meshes with levels of detail are stored differently, so they get their own cache entry
+    uint64_t hash = ContentHash(source.View(), textured) ^ (ORB_Mesh::optimizeMeshes ? 0x6a09e667f3bcc909 : 0) ^
+                    (ORB_Mesh::generateLods ? 0xbb67ae8584caa73b : 0) ^
+                    (static_cast<uint64_t>(ORB_Mesh::normalMode) * 0x3c6ef372fe94f82b);
+    cached = (std::filesystem::path(cache) / std::format("{:016x}.orbm", hash)).string();
+  }
+  if (std::filesystem::exists(cached))
+  {
+    try
+    {
+      m->Load(cached);
+      return;
+    }
+    catch (std::exception const &e)
+    {
+      // Stale or broken cache files are just parsed again and replaced
+      Log(Warning, "Ignoring mesh cache", cached + ":", e.what());
+    }
+  }
+
+  m->Load(path);
+  if (m->Verticies().empty())
+    return;
+  try
+  {
+    // Written next to the real name first so a reader never maps a half written file
+    std::string temp = std::format("{}.{}.tmp", cached, static_cast<void *>(m));
+    std::string_view texture = textured ? static_cast<TexturedMesh *>(m)->TexturePath() : std::string_view();
+    WriteMeshFile(temp, m->DrawMode(), m->Verticies(), m->Indicies(), m->Lods(), texture);
+    std::filesystem::rename(temp, cached);
+  }
+  catch (std::exception const &e)
+  {
+    Log(Warning, "Could not write mesh cache", cached + ":", e.what());
+  }
+}
+
+ORB_Mesh *MeshLibrary::Load(std::string const &path, bool textured, bool async)
+{
+  auto &paths = textured ? _texPaths : _paths;
+  auto found = paths.find(path);
+  if (found != paths.end())
+  {
+    ++found->second.references;
+    return found->second.mesh;
+  }
+
+  ORB_Mesh *m = textured ? new TexturedMesh() : new ORB_Mesh();
+  m->path = path;
+  if (async)
+  {
+    m->State() = MeshState::Loading;
+    // Load never touches GL, the upload waits for Update on the render thread
+    _pending.push_back({m, nullptr, std::async(std::launch::async, [m, path, textured, cache = _cacheDirectory]()
+                                               { LoadCached(m, path, textured, cache); })});
+  }
+  else
+  {
+    try
+    {
+      LoadCached(m, path, textured, _cacheDirectory);
+      m->Upload();
+    }
+    catch (...)
+    {
+      delete m;
+      throw;
+    }
+  }
   _meshes.push_back(m);
+  paths.emplace(path, CachedMesh{m, 1});
+  if (_watcher)
+    _watcher->Watch(path);
   return m;
 }
 
+bool MeshLibrary::Reload(std::string const &file)
+{
+  std::string changed = FileWatcher::Normalize(file);
+  bool found = false;
+  for (auto *paths : {&_paths, &_texPaths})
+  {
+    bool textured = paths == &_texPaths;
+    for (auto &entry : *paths)
+    {
+      if (FileWatcher::Normalize(entry.first) != changed)
+        continue;
+      found = true;
+      // Parsed into a spare mesh so the old one keeps drawing
+      ORB_Mesh *m = textured ? new TexturedMesh() : new ORB_Mesh();
+      std::string path = entry.first;
+      _pending.push_back({m, entry.second.mesh, std::async(std::launch::async, [m, path, textured, cache = _cacheDirectory]()
+                                                           { LoadCached(m, path, textured, cache); })});
+    }
+  }
+  return found;
+}
+
+void MeshLibrary::SetWatcher(FileWatcher *watcher)
+{
+  _watcher = watcher;
+  if (_watcher == nullptr)
+    return;
+  for (auto *paths : {&_paths, &_texPaths})
+    for (auto &entry : *paths)
+      _watcher->Watch(entry.first);
+}
+
+void MeshLibrary::Update()
+{
+  for (auto it = _pending.begin(); it != _pending.end();)
+  {
+    if (it->load.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+      ++it;
+      continue;
+    }
+    ORB_Mesh *m = it->mesh;
+    ORB_Mesh *target = it->target;
+    try
+    {
+      it->load.get();
+      // Reloads keep the format the mesh was made with
+      if (target)
+        m->Format() = target->Format();
+      m->Upload();
+      if (target)
+      {
+        target->Swap(*m);
+        target->State() = MeshState::Ready;
+        Log(Message, "Reloaded mesh", target->path);
+      }
+      else
+        m->State() = MeshState::Ready;
+    }
+    catch (std::exception const &e)
+    {
+      // A broken reload leaves the old geometry in place
+      std::cerr << "ORB ERROR: Failed to load mesh " << (target ? target->path : m->path) << ": " << e.what() << std::endl;
+      if (!target)
+        m->State() = MeshState::Failed;
+    }
+    // The spare mesh ends up with the old buffers, so deleting it frees them
+    if (target)
+      delete m;
+    it = _pending.erase(it);
+  }
+}
+
 void MeshLibrary::DropMesh(ORB_Mesh *m)
 {
+  // Meshes loaded from a file are shared, only the last drop destroys them
+  for (auto *paths : {&_paths, &_texPaths})
+  {
+    auto found = paths->find(m->path);
+    if (found == paths->end() || found->second.mesh != m)
+      continue;
+    if (--found->second.references > 0)
+      return;
+    paths->erase(found);
+  }
+  // The workers still have the mesh, let them finish first
+  for (auto p = _pending.begin(); p != _pending.end();)
+  {
+    if (p->mesh != m && p->target != m)
+    {
+      ++p;
+      continue;
+    }
+    p->load.wait();
+    if (p->target)
+      delete p->mesh;
+    p = _pending.erase(p);
+  }
   auto l = std::find(_meshes.begin(), _meshes.end(), m);
   _meshes.erase(l);
+  // Calls staged for it this frame would be merged into a deleted mesh
+  SubmissionContext::Forget(m);
   delete m;
 }
 
 ORB_Mesh *MeshLibrary::Find(std::string s)
 {
-  auto res = std::find_if(_meshes.begin(), _meshes.end(), [&s](ORB_Mesh *m)
-                          { return m->path == s; });
-  if (res != _meshes.end())
-    return *res;
+  auto res = _paths.find(s);
+  if (res != _paths.end())
+    return res->second.mesh;
+  res = _texPaths.find(s);
+  if (res != _texPaths.end())
+    return res->second.mesh;
   return nullptr;
 }
 
 MeshLibrary::~MeshLibrary()
 {
+  for (auto &p : _pending)
+  {
+    p.load.wait();
+    if (p.target)
+      delete p.mesh;
+  }
+  _pending.clear();
   for (auto m : _meshes)
   {
     delete m;
   }
   _meshes.clear();
+  _paths.clear();
+  _texPaths.clear();
 }
@@ -1,7 +1,10 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <future>
+#include <unordered_map>
 struct ORB_Mesh;
+class FileWatcher;
 
 class MeshLibrary 
 {
@@ -10,16 +13,62 @@ public:
   ~MeshLibrary();
   static MeshLibrary* Instance();
 
+  /**
+   * @brief Get a mesh that was loaded from a file.
+   *
+   * @return the mesh, nullptr if the path has not been loaded
+   */
   ORB_Mesh* Find(std::string);
 
   ORB_Mesh* CreateMesh();
+  /**
+   * @brief Load a mesh file, loading a path that is already loaded hands back the same mesh.
+   */
   ORB_Mesh* CreateMesh(std::string);
   ORB_Mesh* CreateMesh(const char*);
 
   ORB_Mesh* CreateTexMesh();
   ORB_Mesh* CreateTexMesh(std::string);
   ORB_Mesh* CreateTexMesh(const char*);
+
+  /**
+   * @brief Start loading a mesh on a worker thread.
+   *
+   * @return the mesh right away, it is not drawn until its State() is Ready
+   */
+  ORB_Mesh* CreateMeshAsync(std::string);
+  ORB_Mesh* CreateTexMeshAsync(std::string);
+
+  /**
+   * @brief Upload the meshes that finished loading. Called by the renderer between frames.
+   */
+  void Update();
+
+  /**
+   * @brief Keep parsed meshes as binary files so later runs can map them instead of parsing.
+   *
+   * @param directory where the cache files go, they are named after a hash of the source file. Empty turns the cache off
+   */
+  void SetCacheDirectory(std::string directory);
+
+  /**
+   * @brief Load the meshes that came from a file again.
+   * The file is parsed on a worker, the meshes keep drawing their old geometry until Update swaps the new one in.
+   *
+   * @param file the changed file
+   * @return whether any mesh was loaded from the file
+   */
+  bool Reload(std::string const& file);
+  /**
+   * @brief Have every file a mesh is loaded from watched, including meshes loaded later.
+   *
+   * @param watcher the watcher to add the files to, nullptr to stop adding them
+   */
+  void SetWatcher(FileWatcher* watcher);
   
+  /**
+   * @brief Drop a mesh, meshes loaded from a file are only destroyed once every load of them is dropped.
+   */
   void DropMesh(ORB_Mesh*);
   std::vector<ORB_Mesh*> const& GetMeshes() { return _meshes; }
 private:
@@ -29,7 +78,30 @@ private:
   MeshLibrary& operator=(MeshLibrary const&) = delete;
   MeshLibrary(MeshLibrary&&) = delete;
 
+  ORB_Mesh* Load(std::string const& path, bool textured, bool async);
+
+  typedef struct CachedMesh
+  {
+    ORB_Mesh* mesh;
+    int references;
+  }CachedMesh;
+
 
   static inline MeshLibrary* _instance = nullptr;
   std::vector<ORB_Mesh*> _meshes;
+  typedef struct PendingMesh
+  {
+    ORB_Mesh* mesh;
+    // For reloads, the mesh that gets the new geometry once it is uploaded. nullptr for first loads
+    ORB_Mesh* target;
+    // Finishes when Load returns
+    std::future<void> load;
+  }PendingMesh;
+  // Meshes still being parsed
+  std::vector<PendingMesh> _pending;
+  // Loaded files by path, textured and untextured loads of a file are different meshes
+  std::unordered_map<std::string, CachedMesh> _paths;
+  std::unordered_map<std::string, CachedMesh> _texPaths;
+  std::string _cacheDirectory;
+  FileWatcher* _watcher = nullptr;
 };
@@ -0,0 +1,227 @@
+#include "pch.h"
+#include "Mesh Normals.h"
+#include <cstring>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <immintrin.h>
+#define ORB_NORMALS_SSE
+#endif
+
+// The three corners of a triangle, winding fixed so every triangle faces the same way as the first
+static void TriangleCorners(GLenum drawMode, size_t t, uint32_t corners[3])
+{
+  switch (drawMode)
+  {
+  case GL_TRIANGLE_STRIP:
+    // Every other strip triangle is wound backwards
+    corners[0] = static_cast<uint32_t>(t + (t & 1));
+    corners[1] = static_cast<uint32_t>(t + 1 - (t & 1));
+    corners[2] = static_cast<uint32_t>(t + 2);
+    break;
+  case GL_TRIANGLE_FAN:
+    corners[0] = 0;
+    corners[1] = static_cast<uint32_t>(t + 1);
+    corners[2] = static_cast<uint32_t>(t + 2);
+    break;
+  default:
+    corners[0] = static_cast<uint32_t>(t * 3);
+    corners[1] = static_cast<uint32_t>(t * 3 + 1);
+    corners[2] = static_cast<uint32_t>(t * 3 + 2);
+    break;
+  }
+}
+
+static size_t TriangleCount(GLenum drawMode, size_t vertexCount)
+{
+  if (drawMode == GL_TRIANGLES)
+    return vertexCount / 3;
+  return vertexCount < 3 ? 0 : vertexCount - 2;
+}
+
+// Run body over [0, count) in pieces, on other threads when there is enough work
+template <typename F>
+static void ParallelFor(size_t count, F const& body)
+{
+  size_t workers = std::max(1u, std::thread::hardware_concurrency());
+  workers = std::min(workers, count / ParallelNormalThreshold + 1);
+  if (workers <= 1)
+  {
+    body(0, count);
+    return;
+  }
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < workers; ++i)
+    threads.emplace_back([&body, i, workers, count]()
+                         { body(count * i / workers, count * (i + 1) / workers); });
+  body(0, count / workers);
+  for (auto& t : threads)
+    t.join();
+}
+
+#ifdef ORB_NORMALS_SSE
+// cross(b - a, c - a) with one vertex per register, w ends up 0
+static inline __m128 FaceNormal(float const* a, float const* b, float const* c)
+{
+  __m128 va = _mm_loadu_ps(a);
+  __m128 ab = _mm_sub_ps(_mm_loadu_ps(b), va);
+  __m128 ac = _mm_sub_ps(_mm_loadu_ps(c), va);
+  __m128 abYZX = _mm_shuffle_ps(ab, ab, _MM_SHUFFLE(3, 0, 2, 1));
+  __m128 acYZX = _mm_shuffle_ps(ac, ac, _MM_SHUFFLE(3, 0, 2, 1));
+  __m128 n = _mm_sub_ps(_mm_mul_ps(ab, acYZX), _mm_mul_ps(abYZX, ac));
+  return _mm_shuffle_ps(n, n, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+// Unit length, zero vectors stay zero instead of becoming NaN
+static inline __m128 Normalize(__m128 n)
+{
+  __m128 m = _mm_mul_ps(n, n);
+  __m128 sum = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+  sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  __m128 length = _mm_sqrt_ps(sum);
+  __m128 valid = _mm_cmpgt_ps(length, _mm_setzero_ps());
+  return _mm_and_ps(_mm_div_ps(n, length), valid);
+}
+#endif
+
+static inline glm::vec4 FaceNormal(Vertex const& a, Vertex const& b, Vertex const& c)
+{
+#ifdef ORB_NORMALS_SSE
+  glm::vec4 n;
+  _mm_storeu_ps(&n.x, FaceNormal(&a.pos.x, &b.pos.x, &c.pos.x));
+  return n;
+#else
+  return glm::vec4(glm::cross(glm::vec3(b.pos - a.pos), glm::vec3(c.pos - a.pos)), 0);
+#endif
+}
+
+static inline glm::vec4 Normalize(glm::vec4 n)
+{
+#ifdef ORB_NORMALS_SSE
+  _mm_storeu_ps(&n.x, Normalize(_mm_loadu_ps(&n.x)));
+  return n;
+#else
+  float length = glm::length(n);
+  return length > 0 ? n / length : glm::vec4(0);
+#endif
+}
+
+static float CornerAngle(glm::vec3 corner, glm::vec3 a, glm::vec3 b)
+{
+  glm::vec3 u = a - corner, v = b - corner;
+  float lengths = glm::length(u) * glm::length(v);
+  if (lengths <= 0)
+    return 0;
+  return std::acos(std::clamp(glm::dot(u, v) / lengths, -1.0f, 1.0f));
+}
+
+static void FlatNormals(std::span<Vertex> verticies, GLenum drawMode, size_t triangleCount)
+{
+  if (drawMode == GL_TRIANGLES)
+  {
+    // Triangles do not share verticies, so every piece writes its own
+    ParallelFor(triangleCount, [&](size_t begin, size_t end)
+                {
+      for (size_t t = begin; t < end; ++t)
+      {
+        Vertex* v = &verticies[t * 3];
+        glm::vec4 n = Normalize(FaceNormal(v[0], v[1], v[2]));
+        v[0].normal = n;
+        v[1].normal = n;
+        v[2].normal = n;
+      } });
+    return;
+  }
+  // Strips and fans: a vertex takes the normal of the last triangle it is in
+  std::vector<glm::vec4> faces(triangleCount);
+  ParallelFor(triangleCount, [&](size_t begin, size_t end)
+              {
+    for (size_t t = begin; t < end; ++t)
+    {
+      uint32_t c[3];
+      TriangleCorners(drawMode, t, c);
+      faces[t] = Normalize(FaceNormal(verticies[c[0]], verticies[c[1]], verticies[c[2]]));
+    } });
+  if (drawMode == GL_TRIANGLE_FAN)
+    verticies[0].normal = faces.back();
+  for (size_t v = (drawMode == GL_TRIANGLE_FAN ? 1 : 0); v < verticies.size(); ++v)
+  {
+    // Vertex v ends triangle v - 2, the first two only have the first triangle
+    size_t t = v < 2 ? 0 : v - 2;
+    verticies[v].normal = faces[std::min(t, triangleCount - 1)];
+  }
+}
+
+// Group verticies that share a position, returns the first vertex of each one's group
+static std::vector<uint32_t> PositionGroups(std::span<const Vertex> verticies)
+{
+  constexpr uint32_t empty = UINT32_MAX;
+  std::vector<uint32_t> group(verticies.size());
+  size_t capacity = std::bit_ceil(verticies.size() * 2 + 1);
+  std::vector<uint32_t> slots(capacity, empty);
+  for (size_t v = 0; v < verticies.size(); ++v)
+  {
+    uint32_t w[3];
+    std::memcpy(w, &verticies[v].pos, sizeof(w));
+    uint64_t hash = (uint64_t(w[0]) * 0x9e3779b97f4a7c15) ^ (uint64_t(w[1]) * 0xc2b2ae3d27d4eb4f) ^ (uint64_t(w[2]) * 0x165667b19e3779f9);
+    size_t slot = (hash ^ (hash >> 32)) & (capacity - 1);
+    while (slots[slot] != empty && std::memcmp(&verticies[slots[slot]].pos, &verticies[v].pos, sizeof(w)) != 0)
+      slot = (slot + 1) & (capacity - 1);
+    if (slots[slot] == empty)
+      slots[slot] = static_cast<uint32_t>(v);
+    group[v] = slots[slot];
+  }
+  return group;
+}
+
+static void SmoothNormals(std::span<Vertex> verticies, GLenum drawMode, size_t triangleCount, bool angleWeighted)
+{
+  // Weighted normal of every corner, worked out in parallel, then summed into each position
+  std::vector<glm::vec4> corners(triangleCount * 3);
+  ParallelFor(triangleCount, [&](size_t begin, size_t end)
+              {
+    for (size_t t = begin; t < end; ++t)
+    {
+      uint32_t c[3];
+      TriangleCorners(drawMode, t, c);
+      Vertex const& a = verticies[c[0]];
+      Vertex const& b = verticies[c[1]];
+      Vertex const& d = verticies[c[2]];
+      // The cross product is twice the area, so summing it as is weights by area
+      glm::vec4 n = FaceNormal(a, b, d);
+      if (angleWeighted)
+      {
+        n = Normalize(n);
+        corners[t * 3] = n * CornerAngle(a.pos, b.pos, d.pos);
+        corners[t * 3 + 1] = n * CornerAngle(b.pos, d.pos, a.pos);
+        corners[t * 3 + 2] = n * CornerAngle(d.pos, a.pos, b.pos);
+      }
+      else
+        corners[t * 3] = corners[t * 3 + 1] = corners[t * 3 + 2] = n;
+    } });
+
+  std::vector<uint32_t> group = PositionGroups(verticies);
+  std::vector<glm::vec4> sums(verticies.size(), glm::vec4(0));
+  for (size_t t = 0; t < triangleCount; ++t)
+  {
+    uint32_t c[3];
+    TriangleCorners(drawMode, t, c);
+    for (int k = 0; k < 3; ++k)
+      sums[group[c[k]]] += corners[t * 3 + k];
+  }
+  ParallelFor(verticies.size(), [&](size_t begin, size_t end)
+              {
+    for (size_t v = begin; v < end; ++v)
+      verticies[v].normal = Normalize(sums[group[v]]); });
+}
+
+void CalculateNormals(std::span<Vertex> verticies, GLenum drawMode, NormalMode mode)
+{
+  if (drawMode != GL_TRIANGLES && drawMode != GL_TRIANGLE_STRIP && drawMode != GL_TRIANGLE_FAN)
+    return;
+  size_t triangleCount = TriangleCount(drawMode, verticies.size());
+  if (triangleCount == 0)
+    return;
+  if (mode == NormalMode::Flat)
+    FlatNormals(verticies, drawMode, triangleCount);
+  else
+    SmoothNormals(verticies, drawMode, triangleCount, mode == NormalMode::SmoothAngle);
+}
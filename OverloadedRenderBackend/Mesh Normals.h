@@ -0,0 +1,26 @@
+#pragma once
+#include <span>
+#include "Vertex.h"
+
+// How CalculateNormals shades a mesh
+enum class NormalMode : int
+{
+  // Every triangle gets its own normal, strips and fans give each vertex the normal of the last triangle it ends
+  Flat,
+  // Verticies at the same position share the sum of their triangles' normals, bigger triangles count more
+  Smooth,
+  // Like Smooth but weighted by the angle of each triangle's corner, so how a face is split does not matter
+  SmoothAngle
+};
+
+// Meshes with more triangles than this are split across threads
+constexpr size_t ParallelNormalThreshold = 1 << 15;
+
+/**
+ * @brief Calculate the normals of an unindexed mesh.
+ *
+ * @param verticies the verticies, their normals are overwritten
+ * @param drawMode GL_TRIANGLES, GL_TRIANGLE_STRIP or GL_TRIANGLE_FAN, anything else is left alone
+ * @param mode how to shade the mesh
+ */
+void CalculateNormals(std::span<Vertex> verticies, GLenum drawMode, NormalMode mode);
@@ -0,0 +1,494 @@
+#include "pch.h"
+#include "Mesh Optimizer.h"
+#include <unordered_map>
+#include <cstring>
+
+float CalculateACMR(std::span<const uint32_t> indicies, size_t vertexCount, size_t cacheSize)
+{
+  if (indicies.size() < 3)
+    return 0;
+  // A vertex is in the FIFO while fewer than cacheSize misses happened after it went in, 0 is never
+  std::vector<size_t> insertedAt(vertexCount, 0);
+  size_t misses = 0;
+  for (uint32_t v : indicies)
+  {
+    if (insertedAt[v] == 0 || misses - insertedAt[v] >= cacheSize)
+      insertedAt[v] = ++misses;
+  }
+  return static_cast<float>(misses) / static_cast<float>(indicies.size() / 3);
+}
+
+// Sander, Nehab and Barczak, Fast Triangle Reordering for Vertex Locality and Reduced Overdraw
+void OptimizeVertexCache(std::vector<uint32_t>& indicies, size_t vertexCount, size_t cacheSize, std::vector<uint32_t>& clusters)
+{
+  size_t triangleCount = indicies.size() / 3;
+  clusters.clear();
+  if (triangleCount == 0)
+    return;
+
+  // Triangles using each vertex, packed into one list
+  std::vector<uint32_t> live(vertexCount, 0);
+  for (size_t i = 0; i < triangleCount * 3; ++i)
+    ++live[indicies[i]];
+  std::vector<uint32_t> offsets(vertexCount + 1, 0);
+  for (size_t v = 0; v < vertexCount; ++v)
+    offsets[v + 1] = offsets[v] + live[v];
+  std::vector<uint32_t> adjacency(offsets.back());
+  {
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+      adjacency[fill[indicies[i]]++] = static_cast<uint32_t>(i / 3);
+  }
+
+  std::vector<size_t> cacheTime(vertexCount, 0);
+  std::vector<bool> emitted(triangleCount, false);
+  std::vector<uint32_t> deadEnds;
+  std::vector<uint32_t> candidates;
+  std::vector<uint32_t> output;
+  output.reserve(triangleCount * 3);
+  size_t time = cacheSize + 1;
+  size_t cursor = 0;
+
+  // Dead ends are verticies that were used recently, then anything with triangles left
+  auto skipDeadEnd = [&]() -> int64_t
+  {
+    while (!deadEnds.empty())
+    {
+      uint32_t d = deadEnds.back();
+      deadEnds.pop_back();
+      if (live[d] > 0)
+        return d;
+    }
+    while (cursor < vertexCount)
+    {
+      if (live[cursor] > 0)
+        return static_cast<int64_t>(cursor);
+      ++cursor;
+    }
+    return -1;
+  };
+
+  int64_t fanning = skipDeadEnd();
+  clusters.push_back(0);
+  while (fanning >= 0)
+  {
+    candidates.clear();
+    for (uint32_t a = offsets[fanning]; a < offsets[fanning + 1]; ++a)
+    {
+      uint32_t t = adjacency[a];
+      if (emitted[t])
+        continue;
+      for (int c = 0; c < 3; ++c)
+      {
+        uint32_t v = indicies[t * 3 + c];
+        output.push_back(v);
+        deadEnds.push_back(v);
+        candidates.push_back(v);
+        --live[v];
+        if (time - cacheTime[v] > cacheSize)
+          cacheTime[v] = time++;
+      }
+      emitted[t] = true;
+    }
+
+    // The next fan is the candidate that will still be in the cache once its triangles are emitted
+    int64_t next = -1;
+    int64_t best = -1;
+    for (uint32_t v : candidates)
+    {
+      if (live[v] == 0)
+        continue;
+      int64_t priority = 0;
+      if (time - cacheTime[v] + 2 * live[v] <= cacheSize)
+        priority = static_cast<int64_t>(time - cacheTime[v]);
+      if (priority > best)
+      {
+        best = priority;
+        next = v;
+      }
+    }
+    if (next == -1)
+    {
+      next = skipDeadEnd();
+      if (next >= 0)
+        clusters.push_back(static_cast<uint32_t>(output.size() / 3));
+    }
+    fanning = next;
+  }
+  indicies.resize(triangleCount * 3);
+  std::copy(output.begin(), output.end(), indicies.begin());
+}
+
+size_t OptimizeOverdraw(std::span<const Vertex> verticies, std::vector<uint32_t>& indicies, std::vector<uint32_t> const& clusters, size_t cacheSize, float threshold)
+{
+  size_t triangleCount = indicies.size() / 3;
+  if (triangleCount == 0 || clusters.empty())
+    return 0;
+
+  // Split the hard clusters wherever the cache has warmed up enough that a restart costs little
+  float limit = CalculateACMR(indicies, verticies.size(), cacheSize) * threshold;
+  std::vector<uint32_t> starts;
+  {
+    std::vector<size_t> insertedAt(verticies.size(), 0);
+    size_t misses = 0;
+    size_t clusterMisses = 0;
+    size_t next = 0;
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+      bool hard = next < clusters.size() && clusters[next] == t;
+      if (hard)
+        ++next;
+      if (hard || (starts.size() > 0 && t > starts.back() &&
+                   static_cast<float>(clusterMisses) / static_cast<float>(t - starts.back()) <= limit && t - starts.back() >= cacheSize))
+      {
+        starts.push_back(static_cast<uint32_t>(t));
+        clusterMisses = 0;
+        // A new cluster can start anywhere, so it has to assume a cold cache
+        misses += cacheSize;
+      }
+      for (int c = 0; c < 3; ++c)
+      {
+        uint32_t v = indicies[t * 3 + c];
+        if (insertedAt[v] == 0 || misses - insertedAt[v] >= cacheSize)
+        {
+          insertedAt[v] = ++misses;
+          ++clusterMisses;
+        }
+      }
+    }
+  }
+
+  // Area weighted center and normal of the mesh and of every cluster
+  struct cluster
+  {
+    uint32_t start;
+    uint32_t end;
+    float sortKey;
+  };
+  std::vector<cluster> sorted(starts.size());
+  glm::vec3 meshCenter(0);
+  float meshArea = 0;
+  std::vector<glm::vec3> centers(starts.size(), glm::vec3(0));
+  std::vector<glm::vec3> normals(starts.size(), glm::vec3(0));
+  for (size_t c = 0; c < starts.size(); ++c)
+  {
+    sorted[c].start = starts[c];
+    sorted[c].end = c + 1 < starts.size() ? starts[c + 1] : static_cast<uint32_t>(triangleCount);
+    float clusterArea = 0;
+    for (uint32_t t = sorted[c].start; t < sorted[c].end; ++t)
+    {
+      glm::vec3 a = verticies[indicies[t * 3]].pos;
+      glm::vec3 b = verticies[indicies[t * 3 + 1]].pos;
+      glm::vec3 d = verticies[indicies[t * 3 + 2]].pos;
+      glm::vec3 n = glm::cross(b - a, d - a);
+      float area = glm::length(n);
+      glm::vec3 center = (a + b + d) / 3.0f;
+      centers[c] += center * area;
+      normals[c] += n;
+      clusterArea += area;
+    }
+    meshCenter += centers[c];
+    meshArea += clusterArea;
+    if (clusterArea > 0)
+      centers[c] /= clusterArea;
+  }
+  if (meshArea > 0)
+    meshCenter /= meshArea;
+  // Clusters on the outside facing away from the center hide what is behind them, so they go first
+  for (size_t c = 0; c < starts.size(); ++c)
+  {
+    float length = glm::length(normals[c]);
+    sorted[c].sortKey = length > 0 ? glm::dot(centers[c] - meshCenter, normals[c] / length) : 0;
+  }
+  std::stable_sort(sorted.begin(), sorted.end(), [](cluster const& a, cluster const& b)
+                   { return a.sortKey > b.sortKey; });
+
+  std::vector<uint32_t> output;
+  output.reserve(triangleCount * 3);
+  for (auto const& c : sorted)
+    output.insert(output.end(), indicies.begin() + c.start * 3, indicies.begin() + c.end * 3);
+  std::copy(output.begin(), output.end(), indicies.begin());
+  return sorted.size();
+}
+
+void OptimizeVertexFetch(std::vector<Vertex>& verticies, std::vector<uint32_t>& indicies)
+{
+  constexpr uint32_t unused = UINT32_MAX;
+  std::vector<uint32_t> remap(verticies.size(), unused);
+  std::vector<Vertex> ordered;
+  ordered.reserve(verticies.size());
+  for (uint32_t& i : indicies)
+  {
+    if (remap[i] == unused)
+    {
+      remap[i] = static_cast<uint32_t>(ordered.size());
+      ordered.push_back(verticies[i]);
+    }
+    i = remap[i];
+  }
+  verticies = std::move(ordered);
+}
+
+meshOptimizeReport OptimizeMesh(std::vector<Vertex>& verticies, std::vector<uint32_t>& indicies)
+{
+  meshOptimizeReport report;
+  report.acmrBefore = CalculateACMR(indicies, verticies.size());
+  std::vector<uint32_t> clusters;
+  OptimizeVertexCache(indicies, verticies.size(), VertexCacheSize, clusters);
+  report.clusters = OptimizeOverdraw(verticies, indicies, clusters, VertexCacheSize, 1.05f);
+  OptimizeVertexFetch(verticies, indicies);
+  report.acmrAfter = CalculateACMR(indicies, verticies.size());
+  return report;
+}
+
+// Sum of squared distances to a set of planes, the symmetric 4x4 matrix stored as its upper triangle
+typedef struct quadric
+{
+  double a2 = 0, ab = 0, ac = 0, ad = 0;
+  double b2 = 0, bc = 0, bd = 0;
+  double c2 = 0, cd = 0;
+  double d2 = 0;
+
+  void AddPlane(glm::dvec3 n, double d)
+  {
+    a2 += n.x * n.x; ab += n.x * n.y; ac += n.x * n.z; ad += n.x * d;
+    b2 += n.y * n.y; bc += n.y * n.z; bd += n.y * d;
+    c2 += n.z * n.z; cd += n.z * d;
+    d2 += d * d;
+  }
+  quadric& operator+=(quadric const& q)
+  {
+    a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+    b2 += q.b2; bc += q.bc; bd += q.bd;
+    c2 += q.c2; cd += q.cd;
+    d2 += q.d2;
+    return *this;
+  }
+  double Evaluate(glm::dvec3 p) const
+  {
+    double e = a2 * p.x * p.x + 2 * ab * p.x * p.y + 2 * ac * p.x * p.z + 2 * ad * p.x +
+               b2 * p.y * p.y + 2 * bc * p.y * p.z + 2 * bd * p.y +
+               c2 * p.z * p.z + 2 * cd * p.z + d2;
+    return std::max(e, 0.0);
+  }
+}quadric;
+
+static uint64_t EdgeKey(uint32_t a, uint32_t b)
+{
+  return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+}
+
+std::vector<uint32_t> SimplifyMesh(std::span<const Vertex> verticies, std::span<const uint32_t> indicies, size_t targetIndexCount, float& error)
+{
+  error = 0;
+  std::vector<uint32_t> result(indicies.begin(), indicies.end() - indicies.size() % 3);
+  size_t vertexCount = verticies.size();
+  if (result.size() <= targetIndexCount || vertexCount == 0)
+    return result;
+
+  std::vector<glm::dvec3> positions(vertexCount);
+  glm::dvec3 low(verticies[0].pos), high(verticies[0].pos);
+  for (size_t v = 0; v < vertexCount; ++v)
+  {
+    positions[v] = glm::dvec3(verticies[v].pos);
+    low = glm::min(low, positions[v]);
+    high = glm::max(high, positions[v]);
+  }
+  // Changing a UV or color by 1 counts the same as moving the surface by a tenth of the mesh's radius
+  double attributeWeight = glm::length(high - low) * 0.05;
+  attributeWeight *= attributeWeight;
+  auto attributeCost = [&](uint32_t a, uint32_t b)
+  {
+    Vertex const &va = verticies[a], &vb = verticies[b];
+    glm::vec2 tex = va.tex - vb.tex;
+    glm::vec4 color = va.color - vb.color;
+    glm::vec3 normal = glm::vec3(va.normal) - glm::vec3(vb.normal);
+    return attributeWeight * (glm::dot(tex, tex) + glm::dot(color, color) + glm::dot(normal, normal) * 0.25);
+  };
+
+  // Verticies that share a position with another are on a seam, moving one side would open a crack
+  std::vector<uint32_t> canonical(vertexCount);
+  std::vector<bool> locked(vertexCount, false);
+  {
+    struct positionHash
+    {
+      size_t operator()(glm::vec3 const& p) const
+      {
+        uint32_t w[3];
+        std::memcpy(w, &p, sizeof(w));
+        return (size_t(w[0]) * 73856093) ^ (size_t(w[1]) * 19349663) ^ (size_t(w[2]) * 83492791);
+      }
+    };
+    std::unordered_map<glm::vec3, uint32_t, positionHash> first;
+    first.reserve(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v)
+    {
+      auto it = first.try_emplace(glm::vec3(verticies[v].pos), v).first;
+      canonical[v] = it->second;
+      if (it->second != v)
+        locked[v] = locked[it->second] = true;
+    }
+  }
+
+  // Edges used by only one triangle are on the border, collapsing them would shrink the outline
+  std::vector<quadric> quadrics(vertexCount);
+  {
+    std::unordered_map<uint64_t, uint32_t> edges;
+    edges.reserve(result.size());
+    for (size_t t = 0; t < result.size(); t += 3)
+    {
+      uint32_t tri[3] = {result[t], result[t + 1], result[t + 2]};
+      glm::dvec3 n = glm::cross(positions[tri[1]] - positions[tri[0]], positions[tri[2]] - positions[tri[0]]);
+      double length = glm::length(n);
+      if (length > 0)
+      {
+        n /= length;
+        double d = -glm::dot(n, positions[tri[0]]);
+        for (uint32_t v : tri)
+          quadrics[v].AddPlane(n, d);
+      }
+      for (int e = 0; e < 3; ++e)
+        ++edges[EdgeKey(canonical[tri[e]], canonical[tri[(e + 1) % 3]])];
+    }
+    for (size_t t = 0; t < result.size(); t += 3)
+      for (int e = 0; e < 3; ++e)
+      {
+        uint32_t a = result[t + e], b = result[t + (e + 1) % 3];
+        if (edges[EdgeKey(canonical[a], canonical[b])] == 1)
+          locked[a] = locked[b] = true;
+      }
+  }
+
+  struct collapse
+  {
+    uint32_t from;
+    uint32_t to;
+    double cost;
+  };
+  std::vector<collapse> collapses;
+  std::vector<uint32_t> collapseTo(vertexCount);
+  std::vector<bool> touched(vertexCount);
+  std::vector<uint32_t> offsets(vertexCount + 1);
+  std::vector<uint32_t> adjacency;
+  double maxCost = 0;
+
+  while (result.size() > targetIndexCount)
+  {
+    size_t triangleCount = result.size() / 3;
+    // Triangles around each vertex, for checking a collapse does not fold the surface over
+    std::fill(offsets.begin(), offsets.end(), 0);
+    for (uint32_t v : result)
+      ++offsets[v + 1];
+    for (size_t v = 0; v < vertexCount; ++v)
+      offsets[v + 1] += offsets[v];
+    adjacency.resize(result.size());
+    {
+      std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+      for (size_t i = 0; i < result.size(); ++i)
+        adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    collapses.clear();
+    for (size_t t = 0; t < triangleCount; ++t)
+      for (int e = 0; e < 3; ++e)
+      {
+        uint32_t a = result[t * 3 + e], b = result[t * 3 + (e + 1) % 3];
+        // Each direction is only added once, from the triangle that has the edge going that way
+        if (locked[a])
+          continue;
+        quadric q = quadrics[a];
+        q += quadrics[b];
+        collapses.push_back({a, b, q.Evaluate(positions[b]) + attributeCost(a, b)});
+      }
+    if (collapses.empty())
+      break;
+    std::sort(collapses.begin(), collapses.end(), [](collapse const& a, collapse const& b)
+              { return a.cost < b.cost; });
+
+    for (uint32_t v = 0; v < vertexCount; ++v)
+      collapseTo[v] = v;
+    std::fill(touched.begin(), touched.end(), false);
+    size_t removeTarget = (result.size() - targetIndexCount) / 3;
+    size_t removed = 0;
+    for (auto const& c : collapses)
+    {
+      if (removed >= removeTarget)
+        break;
+      if (touched[c.from] || touched[c.to])
+        continue;
+      // Every triangle that keeps its area has to keep facing the same way
+      bool flips = false;
+      size_t degenerate = 0;
+      for (uint32_t a = offsets[c.from]; a < offsets[c.from + 1] && !flips; ++a)
+      {
+        uint32_t const* tri = &result[adjacency[a] * 3];
+        if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to)
+        {
+          ++degenerate;
+          continue;
+        }
+        glm::dvec3 p[3], q[3];
+        for (int k = 0; k < 3; ++k)
+        {
+          p[k] = positions[tri[k]];
+          q[k] = tri[k] == c.from ? positions[c.to] : p[k];
+        }
+        glm::dvec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+        glm::dvec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+        flips = glm::dot(before, after) <= 0;
+      }
+      if (flips || degenerate == 0)
+        continue;
+      collapseTo[c.from] = c.to;
+      // Nothing around the collapse can change again this pass, the adjacency would be stale
+      for (uint32_t a = offsets[c.from]; a < offsets[c.from + 1]; ++a)
+        for (int k = 0; k < 3; ++k)
+          touched[result[adjacency[a] * 3 + k]] = true;
+      quadrics[c.to] += quadrics[c.from];
+      maxCost = std::max(maxCost, c.cost);
+      removed += degenerate;
+    }
+    if (removed == 0)
+      break;
+
+    size_t write = 0;
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+      uint32_t a = collapseTo[result[t * 3]], b = collapseTo[result[t * 3 + 1]], c = collapseTo[result[t * 3 + 2]];
+      if (a == b || b == c || a == c)
+        continue;
+      result[write++] = a;
+      result[write++] = b;
+      result[write++] = c;
+    }
+    result.resize(write);
+  }
+  error = static_cast<float>(std::sqrt(maxCost));
+  return result;
+}
+
+std::vector<meshLod> BuildMeshLods(std::span<const Vertex> verticies, std::vector<uint32_t>& indicies, float radius, bool optimize)
+{
+  std::vector<meshLod> lods;
+  if (indicies.size() / 3 < MinLodTriangles || radius <= 0)
+    return lods;
+  lods.push_back({0, static_cast<uint32_t>(indicies.size()), 0});
+  std::vector<uint32_t> clusters;
+  while (lods.size() < MaxMeshLods)
+  {
+    meshLod const& previous = lods.back();
+    std::span<const uint32_t> source(indicies.data() + previous.offset, previous.count);
+    float error = 0;
+    std::vector<uint32_t> level = SimplifyMesh(verticies, source, previous.count / 6 * 3, error);
+    // Stop once simplifying stops paying for the extra indicies
+    if (level.size() > previous.count * 3 / 4)
+      break;
+    if (optimize)
+      OptimizeVertexCache(level, verticies.size(), VertexCacheSize, clusters);
+    lods.push_back({static_cast<uint32_t>(indicies.size()), static_cast<uint32_t>(level.size()), std::max(error / radius, previous.error)});
+    indicies.insert(indicies.end(), level.begin(), level.end());
+  }
+  if (lods.size() == 1)
+    lods.clear();
+  return lods;
+}
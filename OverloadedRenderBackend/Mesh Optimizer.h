@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "Vertex.h"
+
+// How many transformed verticies the optimizer assumes the GPU keeps around
+constexpr size_t VertexCacheSize = 16;
+// The most levels of detail a mesh keeps, including the full mesh
+constexpr size_t MaxMeshLods = 4;
+// Meshes with fewer triangles than this are not worth simplifying
+constexpr size_t MinLodTriangles = 512;
+
+/**
+ * @brief One level of detail, a range of the mesh's indicies.
+ *
+ * offset - the first index of the level
+ * count - how many indicies it has
+ * error - how far the level is from the full mesh, as a fraction of the mesh's bounding radius
+ */
+typedef struct meshLod
+{
+  uint32_t offset;
+  uint32_t count;
+  float error;
+}meshLod;
+
+/**
+ * @brief Average cache miss ratio of a mesh before and after optimizing.
+ *
+ * acmr - transformed verticies per triangle with a FIFO cache of VertexCacheSize, 0.5 is the best a grid can get and 3 is no reuse at all
+ * clusters - how many groups the triangles were split into to sort for overdraw
+ */
+typedef struct meshOptimizeReport
+{
+  float acmrBefore = 0;
+  float acmrAfter = 0;
+  size_t clusters = 0;
+}meshOptimizeReport;
+
+/**
+ * @brief Simulate a FIFO post transform cache over a triangle list.
+ *
+ * @param indicies the triangle list
+ * @param vertexCount how many verticies the indicies point into
+ * @param cacheSize how many verticies the cache holds
+ * @return how many verticies were transformed for each triangle
+ */
+float CalculateACMR(std::span<const uint32_t> indicies, size_t vertexCount, size_t cacheSize = VertexCacheSize);
+
+/**
+ * @brief Reorder triangles so they reuse the post transform cache (Tipsify).
+ *
+ * @param indicies the triangle list, reordered in place
+ * @param vertexCount how many verticies the indicies point into
+ * @param cacheSize how many verticies the cache holds
+ * @param clusters where to write the first triangle of every run Tipsify had to restart, these are safe to move around
+ */
+void OptimizeVertexCache(std::vector<uint32_t>& indicies, size_t vertexCount, size_t cacheSize, std::vector<uint32_t>& clusters);
+
+/**
+ * @brief Reorder the clusters of a cache optimized triangle list so triangles facing out of the mesh are drawn first.
+ *
+ * @details Clusters are split further wherever the cache has not lost much by it, threshold is how much worse
+ *          than the whole mesh a cluster's ACMR may be.
+ * @param verticies the verticies
+ * @param indicies the triangle list, reordered in place
+ * @param clusters the first triangle of each cluster, from OptimizeVertexCache
+ * @param cacheSize how many verticies the cache holds
+ * @param threshold how much ACMR may be traded for less overdraw, 1.05 keeps it within 5%
+ * @return how many clusters were sorted
+ */
+size_t OptimizeOverdraw(std::span<const Vertex> verticies, std::vector<uint32_t>& indicies, std::vector<uint32_t> const& clusters, size_t cacheSize, float threshold);
+
+/**
+ * @brief Reorder verticies into the order they are first used, unused verticies are dropped.
+ *
+ * @param verticies the verticies, reordered in place
+ * @param indicies the indicies, rewritten to the new order
+ */
+void OptimizeVertexFetch(std::vector<Vertex>& verticies, std::vector<uint32_t>& indicies);
+
+/**
+ * @brief Simplify a triangle list by collapsing edges with the least quadric error (Garland and Heckbert).
+ *
+ * @details Verticies are never moved or added, so the result indexes the same verticies. Verticies on the
+ *          border of the mesh or on a seam between verticies sharing a position are never collapsed.
+ * @param verticies the verticies
+ * @param indicies the triangle list
+ * @param targetIndexCount how many indicies to stop at, the result may have more if nothing else can collapse
+ * @param error where to write the largest distance a collapse moved the surface by
+ * @return the simplified triangle list
+ */
+std::vector<uint32_t> SimplifyMesh(std::span<const Vertex> verticies, std::span<const uint32_t> indicies, size_t targetIndexCount, float& error);
+
+/**
+ * @brief Build levels of detail for a triangle list, each with half the triangles of the last.
+ *
+ * @param verticies the verticies
+ * @param indicies the full triangle list, the levels are appended to it
+ * @param radius the bounding radius of the mesh, errors are stored relative to it
+ * @param optimize whether to reorder each level for the vertex cache
+ * @return the levels, the first is the full mesh. Empty if the mesh is too small to simplify.
+ */
+std::vector<meshLod> BuildMeshLods(std::span<const Vertex> verticies, std::vector<uint32_t>& indicies, float radius, bool optimize);
+
+/**
+ * @brief Run every pass over an indexed triangle list.
+ *
+ * @param verticies the verticies
+ * @param indicies the triangle list
+ * @return the ACMR before and after
+ */
+meshOptimizeReport OptimizeMesh(std::vector<Vertex>& verticies, std::vector<uint32_t>& indicies);
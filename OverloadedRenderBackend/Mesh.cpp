@@ -2,42 +2,194 @@
 #include "Mesh.h"
 #include "Wermal Reader.h"
 #include "Stream.h"
+#include "Mesh Binary.h"
+#include "Obj Reader.h"
 #include "RenderBackend.h"
+#include "ShaderStage.h"
+#include "Mesh Optimizer.h"
+#include "ShaderLog.hpp"
 #include <exception>
+
+// Text meshes bigger than this are split up and parsed on every core
+constexpr size_t ParallelParseThreshold = 1 << 20;
+
+// Read <point> records until the block ends
+static void ReadPoints(WermalReader &file, std::vector<Vertex> &out)
+{
+  while (file.isEOF() == false)
+  {
+    auto d = ReadNextAttribute(file);
+    if (d.first == false)
+      break;
+    // Points are the 14 floats of a Vertex in declaration order, missing values stay 0
+    Vertex v = {};
+    if (Parse<float>(d.second, reinterpret_cast<float *>(&v), sizeof(Vertex) / sizeof(float)) == 0)
+      break;
+    out.push_back(v);
+  }
+}
+
+// Split the points of a large block at record boundaries and parse the pieces in parallel
+static void ReadPointsParallel(WermalReader &file, std::vector<Vertex> &out)
+{
+  std::string_view rest = file.Buffer().substr(file.location());
+  // The block ends at the first closing tag, nothing past it belongs to the mesh
+  size_t blockEnd = rest.find("</");
+  std::string_view block = rest.substr(0, blockEnd);
+  file.Seek(file.location() + block.size());
+
+  size_t workers = std::max(1u, std::thread::hardware_concurrency());
+  workers = std::min(workers, block.size() / (ParallelParseThreshold / 4) + 1);
+  std::vector<std::string_view> chunks;
+  size_t start = 0;
+  for (size_t i = 1; i <= workers && start < block.size(); ++i)
+  {
+    size_t end = i == workers ? block.size() : block.size() * i / workers;
+    // Data lines never hold a tag, so the next '<' is the start of a record
+    end = end < start ? start : block.find('<', end);
+    if (end == std::string_view::npos)
+      end = block.size();
+    chunks.push_back(block.substr(start, end - start));
+    start = end;
+  }
+
+  std::vector<std::vector<Vertex>> results(chunks.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < chunks.size(); ++i)
+  {
+    threads.emplace_back([&chunks, &results, i]()
+    {
+      WermalReader chunk(chunks[i]);
+      results[i].reserve(chunks[i].size() / 48);
+      ReadPoints(chunk, results[i]);
+    });
+  }
+  WermalReader first(chunks[0]);
+  ReadPoints(first, results[0]);
+  for (auto &t : threads)
+    t.join();
+
+  size_t total = out.size();
+  for (auto &r : results)
+    total += r.size();
+  out.reserve(total);
+  for (auto &r : results)
+    out.insert(out.end(), r.begin(), r.end());
+}
 Renderer *ORB_Mesh::_backend = nullptr;
+bool ORB_Mesh::optimizeMeshes = false;
+bool ORB_Mesh::generateLods = true;
+NormalMode ORB_Mesh::normalMode = NormalMode::Flat;
+bool ORB_Mesh::cullMeshes = true;
 ORB_Mesh::~ORB_Mesh()
 {
-  glDeleteBuffers(1, &_buffer);
-  glDeleteVertexArrays(1, &_vao);
+  delete _ring;
+  // Meshes that were only loaded (ConvertMeshFile) never had GL objects
+  if (_arena == nullptr)
+    return;
+  _arena->Free(_allocation);
 }
 
 ORB_Mesh::ORB_Mesh(int mode, std::vector<Vertex> &verts, glm::vec4 &&col)
-    : _drawMode(mode), _buffer(0), _verticies(verts), _color(col)
+    : _drawMode(mode), _verticies(verts), _color(col)
 {
   CreateBuffer();
 }
 
 void ORB_Mesh::Read(std::string file)
 {
-  Stream s(file);
+  Load(file);
+  Upload();
+}
+
+void ORB_Mesh::Upload()
+{
+  CreateBuffer();
+}
+
+void ORB_Mesh::Swap(ORB_Mesh &other)
+{
+  std::swap(_drawMode, other._drawMode);
+  std::swap(_arena, other._arena);
+  std::swap(_allocation, other._allocation);
+  std::swap(_ring, other._ring);
+  std::swap(_verticies, other._verticies);
+  std::swap(_mapped, other._mapped);
+  std::swap(_mappedVerticies, other._mappedVerticies);
+  std::swap(_vertexCount, other._vertexCount);
+  std::swap(_indicies, other._indicies);
+  std::swap(_mappedIndicies, other._mappedIndicies);
+  std::swap(_indexCount, other._indexCount);
+  std::swap(_indexType, other._indexType);
+  std::swap(_lods, other._lods);
+  std::swap(_boundingCenter, other._boundingCenter);
+  std::swap(_boundingRadius, other._boundingRadius);
+  std::swap(_boundsMin, other._boundsMin);
+  std::swap(_boundsMax, other._boundsMax);
+  std::swap(_format, other._format);
+}
+
+void ORB_Mesh::Load(std::string file)
+{
   fileTypes type = GetFileType(file.substr(file.rfind('.')));
   switch (type)
   {
+  case fileTypes::binary:
+    ReadBinary(MappedFile(file));
+    break;
+  case fileTypes::obj:
+    ReadObj(::ReadObj(file));
+    break;
   case fileTypes::dat:
   {
-    std::string token = makeLowerCase(s.readString());
+    WermalReader s(file);
+    std::string token = makeLowerCase(std::string(s.ReadToken()));
     if (token != "<mesh>")
       return;
+    Read(s);
   }
   break;
   default:
     throw std::runtime_error("File types not handled yet");
     break;
   }
-  Read(s);
 }
 
-void ORB_Mesh::Read(Stream &file)
+void ORB_Mesh::ReadBinary(MappedFile&& file)
+{
+  MeshFileHeader const& header = ReadMeshHeader(file);
+  _drawMode = header.drawMode;
+  _mappedVerticies = ReadMeshVerticies(file);
+  _mappedIndicies = ReadMeshIndicies(file);
+  auto lods = ReadMeshLods(file);
+  _lods.assign(lods.begin(), lods.end());
+  _mapped = std::move(file);
+}
+
+void ORB_Mesh::ReadObj(ObjMesh&& obj)
+{
+  _drawMode = GL_TRIANGLES;
+  // The importer already welded the verticies, they can be drawn as is
+  if (obj.hasNormals)
+  {
+    _verticies = std::move(obj.verticies);
+    _indicies = std::move(obj.indices);
+    Optimize();
+    BuildLods();
+    return;
+  }
+  // Flat normals are per face, so expand the faces out, fill them in and weld what is left
+  _verticies.clear();
+  _verticies.reserve(obj.indices.size());
+  for (uint32_t i : obj.indices)
+    _verticies.push_back(obj.verticies[i]);
+  CalculateNormals();
+  Weld();
+  Optimize();
+  BuildLods();
+}
+
+void ORB_Mesh::Read(WermalReader &file)
 {
   fileTypes type = GetFileType(file.Path().substr(file.Path().rfind('.')));
   switch (type)
@@ -47,21 +199,11 @@ void ORB_Mesh::Read(Stream &file)
     auto p = ReadNextAttribute(file);
     if (p.first == false)
       break;
-    _drawMode = *Parse<int>(p.second);
-    while (file.isEOF() == false)
-    {
-
-      Vertex v = Vertex();
-      auto d = ReadNextAttribute(file);
-      if (d.first == true && d.second.get()[0] != '\0')
-      {
-        v = *reinterpret_cast<Vertex *>(Parse<float>(d.second).get());
-        // std::cout << v << std::endl;
-        _verticies.push_back(v);
-      }
-      else
-        break;
-    }
+    _drawMode = Parse<int>(p.second);
+    if (file.Buffer().size() - file.location() > ParallelParseThreshold)
+      ReadPointsParallel(file, _verticies);
+    else
+      ReadPoints(file, _verticies);
   }
   break;
   default:
@@ -70,8 +212,9 @@ void ORB_Mesh::Read(Stream &file)
   }
 
   CalculateNormals();
-  CreateBuffer();
-  // glWriteBuffer("VBO", v.size() * sizeof(Vertex), (void*)v.data());
+  Weld();
+  Optimize();
+  BuildLods();
 }
 
 glm::vec4 const &ORB_Mesh::Color() const
@@ -89,24 +232,229 @@ std::vector<Vertex> const &ORB_Mesh::Verticies() const
   return _verticies;
 }
 
+std::vector<uint32_t> const &ORB_Mesh::Indicies() const
+{
+  return _indicies;
+}
+
+void ORB_Mesh::Weld()
+{
+  if (_verticies.empty() || !_indicies.empty())
+    return;
+  size_t count = _verticies.size();
+  WeldVerticies(_verticies, _indicies);
+  // Nothing was shared, the index buffer would only cost bandwidth
+  if (_verticies.size() == count)
+    _indicies.clear();
+}
+
+void ORB_Mesh::Optimize()
+{
+  if (!optimizeMeshes || _drawMode != GL_TRIANGLES || _indicies.size() < 3)
+    return;
+  meshOptimizeReport report = OptimizeMesh(_verticies, _indicies);
+  Log(Message, "Optimized mesh", path, "ACMR:", report.acmrBefore, "->", report.acmrAfter, "over", report.clusters, "clusters");
+}
+
+void ORB_Mesh::BuildLods()
+{
+  if (!generateLods || _drawMode != GL_TRIANGLES || _indicies.empty())
+    return;
+  CalculateBounds(_verticies);
+  _lods = BuildMeshLods(_verticies, _indicies, _boundingRadius, optimizeMeshes);
+}
+
+void ORB_Mesh::CalculateBounds(std::span<const Vertex> verticies)
+{
+  if (verticies.empty())
+    return;
+  glm::vec3 low = verticies[0].pos, high = verticies[0].pos;
+  for (auto const &v : verticies)
+  {
+    low = glm::min(low, glm::vec3(v.pos));
+    high = glm::max(high, glm::vec3(v.pos));
+  }
+  _boundsMin = low;
+  _boundsMax = high;
+  _boundingCenter = (low + high) * 0.5f;
+  float radius = 0;
+  for (auto const &v : verticies)
+    radius = std::max(radius, glm::distance(_boundingCenter, glm::vec3(v.pos)));
+  _boundingRadius = radius;
+}
+
+std::vector<meshLod> const &ORB_Mesh::Lods() const
+{
+  return _lods;
+}
+
+int ORB_Mesh::SelectLod(float pixels) const
+{
+  // The errors only grow, so the first level that is too far off ends the search
+  int lod = 0;
+  for (size_t i = 1; i < _lods.size(); ++i)
+  {
+    if (_lods[i].error * pixels >= 1.0f)
+      break;
+    lod = static_cast<int>(i);
+  }
+  return lod;
+}
+
+glm::vec3 ORB_Mesh::BoundingCenter() const
+{
+  return _boundingCenter;
+}
+
+float ORB_Mesh::BoundingRadius() const
+{
+  return _boundingRadius;
+}
+
+glm::vec3 ORB_Mesh::BoundsMin() const
+{
+  return _boundsMin;
+}
+
+glm::vec3 ORB_Mesh::BoundsMax() const
+{
+  return _boundsMax;
+}
+
+bool ORB_Mesh::Visible(Frustum const &frustum, glm::mat4 const &model) const
+{
+  glm::vec3 center = model * glm::vec4(_boundingCenter, 1);
+  glm::vec3 axes[3] = {model[0], model[1], model[2]};
+  // The sphere is the cheap test, most of what gets thrown away fails it
+  float scale = std::max({glm::length(axes[0]), glm::length(axes[1]), glm::length(axes[2])});
+  if (!frustum.SphereVisible(center, _boundingRadius * scale))
+    return false;
+  // The box after the model matrix turns it, grown back to line up with the axes
+  glm::vec3 extents = (_boundsMax - _boundsMin) * 0.5f;
+  glm::vec3 worldExtents = glm::abs(axes[0]) * extents.x + glm::abs(axes[1]) * extents.y + glm::abs(axes[2]) * extents.z;
+  return frustum.BoxVisible(center, worldExtents);
+}
+
+void ORB_Mesh::Cull(Frustum const &frustum)
+{
+  for (auto &calls : _renderCalls)
+    std::erase_if(calls, [&](affineInstance const &i)
+                  { return !Visible(frustum, InstanceMatrix(i)); });
+  for (auto &calls : _flatCalls)
+    std::erase_if(calls, [&](flatInstance const &i)
+                  { return !Visible(frustum, InstanceMatrix(i)); });
+}
+
 GLuint &ORB_Mesh::DrawMode()
 {
   return _drawMode;
 }
 
+MeshState ORB_Mesh::State() const
+{
+  return _state;
+}
+
+MeshState &ORB_Mesh::State()
+{
+  return _state;
+}
+
+VertexFormat ORB_Mesh::Format() const
+{
+  return _format;
+}
+
+VertexFormat &ORB_Mesh::Format()
+{
+  return _format;
+}
+
+InstanceFormat ORB_Mesh::InstanceLayout() const
+{
+  return _instanceFormat;
+}
+
+void ORB_Mesh::InstanceLayout(InstanceFormat format)
+{
+  Reset();
+  _instanceFormat = format;
+}
+
+bool ORB_Mesh::Dynamic() const
+{
+  return _dynamic;
+}
+
+bool &ORB_Mesh::Dynamic()
+{
+  return _dynamic;
+}
+
+bool ORB_Mesh::UpdateVerticies(size_t offset, std::span<const Vertex> verticies)
+{
+  if (_arena == nullptr || offset + verticies.size() > _vertexCount)
+    return false;
+  if (verticies.empty())
+    return true;
+  if (_ring == nullptr)
+  {
+    // Mapped meshes have no copy of their verticies left, the arena still does
+    std::vector<char> current(_vertexCount * _arena->Stride());
+    if (_verticies.empty())
+      glGetNamedBufferSubData(_arena->VertexBuffer(), _arena->BaseVertex(_allocation) * _arena->Stride(), current.size(), current.data());
+    else if (IsVertexLayout(_arena->Layout(), _arena->Stride()))
+      std::memcpy(current.data(), _verticies.data(), current.size());
+    else
+      PackVerticies(_verticies, _arena->Layout(), _arena->Stride(), current);
+    _ring = new VertexRing(_arena->Layout(), _arena->Stride(), current);
+  }
+  _ring->Write(offset, verticies);
+
+  // Culling has to know where the verticies went
+  if (!_verticies.empty())
+  {
+    std::copy(verticies.begin(), verticies.end(), _verticies.begin() + offset);
+    CalculateBounds(_verticies);
+  }
+  else
+  {
+    for (auto const &v : verticies)
+    {
+      _boundsMin = glm::min(_boundsMin, glm::vec3(v.pos));
+      _boundsMax = glm::max(_boundsMax, glm::vec3(v.pos));
+    }
+    _boundingCenter = (_boundsMin + _boundsMax) * 0.5f;
+    _boundingRadius = glm::distance(_boundingCenter, _boundsMax);
+  }
+  return true;
+}
+
 GLuint ORB_Mesh::Buffer() const
 {
-  return _buffer;
+  return _arena ? _arena->VertexBuffer() : 0;
 }
 
 GLuint ORB_Mesh::VAO() const
 {
-  return _vao;
+  if (_ring)
+    return _ring->VAO(_arena->IndexBuffer());
+  return _arena ? _arena->VAO() : 0;
 }
 
 GLuint ORB_Mesh::Size() const
 {
-  return static_cast<GLuint>(_verticies.size());
+  return _vertexCount;
+}
+
+GLuint ORB_Mesh::IndexCount() const
+{
+  return _indexCount;
+}
+
+GLenum ORB_Mesh::IndexType() const
+{
+  return _indexType;
 }
 
 std::ostream &operator<<(std::ostream &os, glm::vec4 const &p)
@@ -129,64 +477,154 @@ void ORB_Mesh::Dump() const
 
 void ORB_Mesh::EndMesh()
 {
-  if (_buffer == 0b11111111111111111111111111111111)
+  if (_arena == nullptr)
   {
     CalculateNormals();
+    // Dynamic meshes are updated by the offsets they were built with
+    if (!_dynamic)
+    {
+      Weld();
+      Optimize();
+    }
     CreateBuffer();
   }
 }
 void ORB_Mesh::Render()
 {
-  _backend->WriteBuffer("RenderBuffer", sizeof(RenderInformation) * _renderCalls.size(), _renderCalls.data());
-  glBindVertexArray(_vao);
-  glBindBuffer(GL_ARRAY_BUFFER, _buffer);
-  glDrawArraysInstanced(_drawMode, 0, _verticies.size(), _renderCalls.size());
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  if (_state != MeshState::Ready)
+    return;
+  _backend->SetVertexFormat(_format);
+  _backend->SetInstanceFormat(_instanceFormat);
+  glBindVertexArray(VAO());
+  // One instanced draw for each level of detail that has calls
+  for (size_t lod = 0; lod < MaxMeshLods; ++lod)
+  {
+    auto calls = CallData(static_cast<int>(lod));
+    if (calls.empty())
+      continue;
+    _backend->Instances().Write(0, calls.data(), calls.size());
+    Draw(static_cast<int>(lod), static_cast<GLsizei>(CallCount(static_cast<int>(lod))));
+  }
   glBindVertexArray(0);
 }
+
+void ORB_Mesh::Draw(int lod, GLsizei instances) const
+{
+  meshRange range = Range(lod);
+  if (_indexCount != 0)
+  {
+    size_t indexSize = _indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    glDrawElementsInstancedBaseVertex(_drawMode, range.count, _indexType, reinterpret_cast<void *>(range.first * indexSize), instances, range.baseVertex);
+  }
+  else
+    glDrawArraysInstanced(_drawMode, range.first, range.count, instances);
+  Fence();
+}
+
+meshRange ORB_Mesh::Range(int lod) const
+{
+  GLint baseVertex = _ring ? _ring->BaseVertex() : _arena->BaseVertex(_allocation);
+  if (_indexCount == 0)
+    return {static_cast<GLuint>(baseVertex), _vertexCount, 0};
+  // Negative levels draw the full mesh, like ones past the last level built
+  bool built = lod >= 0 && static_cast<size_t>(lod) < _lods.size();
+  GLuint first = built ? _lods[lod].offset : 0;
+  GLuint count = built ? _lods[lod].count : _indexCount;
+  // Allocations start on 4 bytes, so the offset is always a whole number of indicies
+  size_t indexSize = _indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+  GLuint start = static_cast<GLuint>(_arena->IndexOffset(_allocation) / indexSize);
+  return {start + first, count, baseVertex};
+}
+
+void ORB_Mesh::Fence() const
+{
+  // The copy just drawn is not written again until the GPU is done with it
+  if (_ring)
+    _ring->Fence();
+}
+
+size_t ORB_Mesh::CallCount(int lod) const
+{
+  return _instanceFormat == InstanceFormat::Flat ? _flatCalls[lod].size() : _renderCalls[lod].size();
+}
+
+std::span<const std::byte> ORB_Mesh::CallData(int lod) const
+{
+  if (_instanceFormat == InstanceFormat::Flat)
+    return std::as_bytes(std::span(_flatCalls[lod]));
+  return std::as_bytes(std::span(_renderCalls[lod]));
+}
 void ORB_Mesh::Reset() 
 {
-  _renderCalls.clear();
+  for (auto &calls : _renderCalls)
+    calls.clear();
+  for (auto &calls : _flatCalls)
+    calls.clear();
 }
 void ORB_Mesh::AddCall(glm::mat4 matrix, glm::vec3 color, int matID) {
-  _renderCalls.push_back({.matrix = matrix, .normalMatrix = glm::inverseTranspose(matrix), .color = color, .materialID = matID});
+  AddCall({.matrix = matrix, .normalMatrix = {}, .color = color, .materialID = matID});
 }
-void ORB_Mesh::AddCall(RenderInformation const &r)
+void ORB_Mesh::AddCall(RenderInformation const &r, int lod)
 {
-  _renderCalls.push_back(r);
+  // The normal matrix is worked out on the GPU, so it is never read here
+  lod = std::clamp(lod, 0, static_cast<int>(MaxMeshLods) - 1);
+  if (_instanceFormat == InstanceFormat::Flat)
+    _flatCalls[lod].push_back(FlatInstance(r.matrix, r.color, r.materialID));
+  else
+    _renderCalls[lod].push_back(AffineInstance(r.matrix, r.color, r.materialID));
 }
 void CheckError(int);
 void ORB_Mesh::CreateBuffer()
 {
   if (_backend->QueryAndSet("primary") || _backend->QueryAndSet("default"))
   {
-    glCreateBuffers(1, &_buffer);
-    glGenVertexArrays(1, &_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, _buffer);
-    glBufferData(GL_ARRAY_BUFFER, _verticies.size() * sizeof(Vertex), nullptr, GL_STATIC_DRAW);
-    // std::cout << offsetof(Vertex, pos) << " " << offsetof(Vertex, color) << " " << offsetof(Vertex, normal) << " " << offsetof(Vertex, tex) << std::endl;
-#ifndef __CLANG
-    if constexpr (std::endian::native == std::endian::little)
+    // Mapped binary meshes upload straight from the file
+    std::span<const Vertex> verticies = _mapped.Open() ? _mappedVerticies : std::span<const Vertex>(_verticies);
+    // Compact meshes have their own layout, the stage's shaders read it through the same locations
+    bool full = _format == VertexFormat::Full;
+    auto const &layout = full ? _backend->VertexLayout() : FormatLayout(_format);
+    size_t stride = full ? _backend->VertexStride() : FormatStride(_format);
+    void const *vertexData = verticies.data();
+    std::vector<char> packed;
+    if (!full || !IsVertexLayout(layout, stride))
     {
-      glBufferData(GL_ARRAY_BUFFER, _verticies.size() * sizeof(Vertex), nullptr, GL_STATIC_DRAW);
-      for (int i = 0; i < _verticies.size(); i++)
-      {
-        Vertex &v = _verticies[i];
-        glBufferSubData(GL_ARRAY_BUFFER, (i * sizeof(Vertex)) + 0, sizeof(Vertex::tex), &(v.tex));
-        glBufferSubData(GL_ARRAY_BUFFER, (i * sizeof(Vertex)) + 0 + sizeof(glm::vec2), sizeof(Vertex::normal), &(v.normal));
-        glBufferSubData(GL_ARRAY_BUFFER, (i * sizeof(Vertex)) + 0 + sizeof(glm::vec2) + sizeof(glm::vec4), sizeof(Vertex::color), &(v.normal));
-        glBufferSubData(GL_ARRAY_BUFFER, (i * sizeof(Vertex)) + 0 + sizeof(glm::vec2) + (sizeof(glm::vec4) * 2), sizeof(Vertex::pos), &(v.pos));
-      }
+      PackVerticies(verticies, layout, stride, packed);
+      vertexData = packed.data();
     }
-    else if constexpr (std::endian::native == std::endian::big)
+    _vertexCount = static_cast<GLuint>(verticies.size());
+    CalculateBounds(verticies);
+
+    std::span<const uint32_t> indicies = _mapped.Open() ? _mappedIndicies : std::span<const uint32_t>(_indicies);
+    void const *indexData = indicies.data();
+    size_t indexBytes = indicies.size_bytes();
+    std::vector<uint16_t> shortIndicies;
+    if (!indicies.empty())
     {
-#endif
-      glBufferData(GL_ARRAY_BUFFER, _verticies.size() * sizeof(Vertex), _verticies.data(), GL_STATIC_DRAW);
-#ifndef __CLANG
+      // Most meshes fit in 16 bit indicies, which halves what the GPU reads for them
+      if (verticies.size() <= UINT16_MAX + 1)
+      {
+        shortIndicies.assign(indicies.begin(), indicies.end());
+        indexData = shortIndicies.data();
+        indexBytes = shortIndicies.size() * sizeof(uint16_t);
+        _indexType = GL_UNSIGNED_SHORT;
+      }
+      else
+        _indexType = GL_UNSIGNED_INT;
+      // Levels of detail sit after the full mesh in the same range
+      _indexCount = static_cast<GLuint>(_lods.empty() ? indicies.size() : _lods[0].count);
     }
-#endif
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    _backend->SetBindings(_buffer, _vao);
+
+    // Meshes that are uploaded again give their old range back first, updates start over from the new verticies
+    if (_arena != nullptr)
+      _arena->Free(_allocation);
+    delete _ring;
+    _ring = nullptr;
+    _arena = GeometryArena::Find(layout, stride);
+    _allocation = _arena->Allocate(vertexData, verticies.size(), indexData, indexBytes);
+    // The GPU owns the data now, drop the mapping
+    _mappedVerticies = {};
+    _mappedIndicies = {};
+    _mapped.Close();
   }
   else
   {
@@ -196,33 +634,10 @@ void ORB_Mesh::CreateBuffer()
 
 void ORB_Mesh::CalculateNormals()
 {
-  switch (_drawMode)
-  {
-  case GL_TRIANGLES:
-    for (int i = 0; i < _verticies.size() - 2; i += 3)
-    {
-      Vertex &a = _verticies[i];
-      Vertex &b = _verticies[i + 1];
-      Vertex &c = _verticies[i + 2];
-
-      glm::vec3 ab = b.pos - a.pos;
-      glm::vec3 ac = c.pos - a.pos;
-      glm::vec4 normal = glm::vec4(glm::normalize(glm::cross(ab, ac)), 0);
-      a.normal = normal;
-      b.normal = normal;
-      c.normal = normal;
-    }
-    break;
-  case GL_TRIANGLE_STRIP:
-
-    break;
-  case GL_TRIANGLE_FAN:
-    Vertex &first = _verticies[0];
-    for (int i = 1; i < _verticies.size() - 1; i += 1)
-    {
-    }
-    break;
-  }
+  // Mapped meshes come with their normals already baked in
+  if (_verticies.empty())
+    return;
+  ::CalculateNormals(_verticies, _drawMode, normalMode);
 }
 
 GLuint ORB_Mesh::DrawMode() const
@@ -2,9 +2,22 @@
 #include <glm.hpp>
 #include <vector>
 #include <string>
+#include <span>
 #include "Stream.h"
 #include "Vertex.h"
+#include "Mapped File.h"
+#include "Mesh Optimizer.h"
+#include "Mesh Normals.h"
+#include "Geometry Arena.h"
+#include "Vertex Ring.h"
+#include "Frustum.h"
+#include "Instance Data.h"
 class Renderer;
+class WermalReader;
+struct ObjMesh;
+/**
+ * @brief The object being drawn, stored calls keep it as an affineInstance or flatInstance.
+ */
 typedef struct RenderInformation {
 
   glm::mat4 matrix;
@@ -14,6 +27,31 @@ typedef struct RenderInformation {
   int materialID  = 0;
 
 }RenderInformation;
+
+// Where a mesh is in its life, only Ready meshes get drawn
+enum class MeshState : int
+{
+  Loading,
+  Ready,
+  Failed
+};
+
+/**
+ * @brief The part of the arena a level of detail is drawn from.
+ *
+ * first - the first index, or the first vertex for meshes without indicies
+ * count - how many indicies or verticies to draw
+ * baseVertex - added to every index
+ */
+typedef struct meshRange
+{
+  GLuint first;
+  GLuint count;
+  GLint baseVertex;
+}meshRange;
+
+struct ORB_Texture;
+
 struct ORB_Mesh 
 {
 public:
@@ -21,45 +59,254 @@ public:
   virtual ~ORB_Mesh();
   ORB_Mesh(int mode, std::vector<Vertex>& verts, glm::vec4&& col);
   ORB_Mesh() = default;
+  /**
+   * @brief Load a mesh file and upload it.
+   *
+   * @param file the path to the mesh (.dat, .obj or .orbm)
+   */
   virtual void Read(std::string file);
-  virtual void Read(Stream& file);
+  /**
+   * @brief Parse the body of a text mesh, does not touch the GPU.
+   *
+   * @param file reader positioned after the mesh tag
+   */
+  virtual void Read(WermalReader& file);
+  /**
+   * @brief Load a mesh file without uploading it, EndMesh finishes the mesh.
+   *
+   * @details Binary meshes stay mapped until they are uploaded
+   * @param file the path to the mesh
+   */
+  virtual void Load(std::string file);
+  /**
+   * @brief Send a loaded mesh to the GPU, must be called on the render thread.
+   */
+  virtual void Upload();
+  /**
+   * @brief Trade geometry and GPU buffers with another mesh, draws queued on either mesh stay where they are.
+   *
+   * @param other the mesh to trade with, must be the same kind of mesh
+   */
+  virtual void Swap(ORB_Mesh& other);
   virtual void Execute() const {};
+  /**
+   * @brief Get the texture stored calls are drawn with, nullptr for none.
+   */
+  virtual ORB_Texture* Texture() const { return nullptr; }
 
   glm::vec4 const& Color() const;
   glm::vec4 & Color();
 
   void AddVertex(Vertex const&);
   std::vector<Vertex> const& Verticies() const;
+  /**
+   * @brief Get the indicies of a welded mesh, empty if every vertex was unique.
+   */
+  std::vector<uint32_t> const& Indicies() const;
 
   GLuint DrawMode() const;
   GLuint& DrawMode();
 
+  MeshState State() const;
+  MeshState& State();
+
+  /**
+   * @brief How the verticies are stored on the GPU, set before the mesh is uploaded.
+   */
+  VertexFormat Format() const;
+  VertexFormat& Format();
+  /**
+   * @brief How the stored calls are sent to the GPU, changing it drops the calls queued so far.
+   */
+  InstanceFormat InstanceLayout() const;
+  void InstanceLayout(InstanceFormat format);
+  /**
+   * @brief Whether the mesh keeps its verticies in the order they were added, set before EndMesh.
+   *
+   * @details Dynamic meshes are not welded or optimized, so the offsets given to UpdateVerticies are the ones
+   * the verticies were added at.
+   */
+  bool Dynamic() const;
+  bool& Dynamic();
+  /**
+   * @brief Replace some of the uploaded verticies, must be called on the render thread.
+   *
+   * @details The first update moves the verticies into a ring of their own, see VertexRing, the indicies stay
+   * in the arena.
+   * @param offset the first vertex to replace
+   * @param verticies the new verticies
+   * @return false if the range is past the end of the mesh or the mesh is not uploaded
+   */
+  bool UpdateVerticies(size_t offset, std::span<const Vertex> verticies);
+
+  /**
+   * @brief Get the arena's vertex buffer, shared with every mesh of the same vertex layout.
+   */
   GLuint Buffer() const;
+  /**
+   * @brief Get the VAO to draw with, the arena's unless the verticies have been updated.
+   */
   GLuint VAO() const;
   GLuint Size() const;
+  /**
+   * @brief Get how many indicies to draw, 0 when the mesh is drawn with glDrawArrays.
+   */
+  GLuint IndexCount() const;
+  /**
+   * @brief Get the type of the index buffer, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.
+   */
+  GLenum IndexType() const;
+  /**
+   * @brief Get the levels of detail, empty if the mesh only has the full level.
+   */
+  std::vector<meshLod> const& Lods() const;
+  /**
+   * @brief Pick the coarsest level of detail that is off by less than a pixel.
+   *
+   * @param pixels the bounding radius of the mesh on screen in pixels
+   * @return the level, 0 is the full mesh
+   */
+  int SelectLod(float pixels) const;
+  /**
+   * @brief Get the center of the bounding sphere of the verticies.
+   */
+  glm::vec3 BoundingCenter() const;
+  /**
+   * @brief Get the radius of the bounding sphere of the verticies.
+   */
+  float BoundingRadius() const;
+  /**
+   * @brief Get the low corner of the axis aligned box around the verticies.
+   */
+  glm::vec3 BoundsMin() const;
+  /**
+   * @brief Get the high corner of the axis aligned box around the verticies.
+   */
+  glm::vec3 BoundsMax() const;
+  /**
+   * @brief Whether any of the mesh might be seen through a frustum.
+   *
+   * @param frustum the planes, in the space the model matrix moves the mesh to
+   * @param model the object matrix it is drawn with
+   */
+  bool Visible(Frustum const& frustum, glm::mat4 const& model) const;
+  /**
+   * @brief Drop the stored render calls that can not be seen.
+   *
+   * @param frustum the planes in world space
+   */
+  void Cull(Frustum const& frustum);
+  /**
+   * @brief Issue the draw for the mesh's range of the arena, the VAO must be bound.
+   *
+   * @param lod the level of detail to draw
+   * @param instances how many instances to draw
+   */
+  void Draw(int lod, GLsizei instances = 1) const;
+  /**
+   * @brief Get where a level of detail is in the arena, for building indirect draws.
+   */
+  meshRange Range(int lod) const;
+  /**
+   * @brief Mark the verticies as read by the draw just issued, only updated meshes have to wait for it.
+   */
+  void Fence() const;
+  /**
+   * @brief Get how many stored render calls are queued for a level of detail.
+   */
+  size_t CallCount(int lod) const;
+  /**
+   * @brief Get the stored render calls queued for a level of detail, in the mesh's instance layout.
+   */
+  std::span<const std::byte> CallData(int lod) const;
   void Dump() const;
   void EndMesh();
   void Render();
   void Reset();
   void AddCall(glm::mat4 matrix, glm::vec3 color, int matID);
-  void AddCall(RenderInformation const &);
+  /**
+   * @brief Queue an instance for stored rendering.
+   *
+   * @param lod the level of detail to draw it with, see SelectLod
+   */
+  void AddCall(RenderInformation const &, int lod = 0);
 
   static Renderer* _backend;
+  // Reorder indexed triangle meshes for the vertex cache and overdraw when they are built
+  static bool optimizeMeshes;
+  // Build levels of detail for loaded triangle meshes
+  static bool generateLods;
+  // How CalculateNormals shades meshes
+  static NormalMode normalMode;
+  // Skip draws of meshes that are entirely off screen
+  static bool cullMeshes;
 
   int renderLayer = 1;
   std::string path;
 
-private:
+protected:
   void CreateBuffer();
+  /**
+   * @brief Take ownership of a mapped binary mesh, verticies are uploaded straight from the mapping.
+   *
+   * @param file the mapped .orbm file
+   */
+  void ReadBinary(MappedFile&& file);
+  /**
+   * @brief Take the geometry of an imported OBJ.
+   *
+   * @param obj the imported mesh, drawn as GL_TRIANGLES
+   */
+  void ReadObj(ObjMesh&& obj);
+
+private:
   void CalculateNormals();
+  /**
+   * @brief Merge duplicate verticies, the mesh is drawn indexed when any were found.
+   */
+  void Weld();
+  /**
+   * @brief Run the mesh optimizer over indexed triangle lists, when optimizeMeshes is set.
+   */
+  void Optimize();
+  /**
+   * @brief Build the levels of detail of a loaded triangle list, when generateLods is set.
+   */
+  void BuildLods();
+  /**
+   * @brief Fit the bounding sphere around the verticies.
+   */
+  void CalculateBounds(std::span<const Vertex> verticies);
   
   GLuint _drawMode = 6;
-  GLuint _buffer = 0b11111111111111111111111111111111; // 32 1s, the same as 0xffffffff
-  GLuint _vao = 0b11111111111111111111111111111111; // 32 1s, the same as 0xffffffff
+  // Where the mesh lives on the GPU, nullptr until it is uploaded
+  GeometryArena* _arena = nullptr;
+  uint32_t _allocation = 0;
+  // The verticies of updated meshes, nullptr until the first update
+  VertexRing* _ring = nullptr;
+  bool _dynamic = false;
 
   
-  std::vector<RenderInformation> _renderCalls;
+  // Stored render calls for each level of detail, only the ones of the instance layout are used
+  std::vector<affineInstance> _renderCalls[MaxMeshLods];
+  std::vector<flatInstance> _flatCalls[MaxMeshLods];
+  InstanceFormat _instanceFormat = InstanceFormat::Affine;
   std::vector<Vertex> _verticies;
+  std::vector<uint32_t> _indicies;
+  // Binary meshes are read in place and never copied into _verticies
+  MappedFile _mapped;
+  std::span<const Vertex> _mappedVerticies;
+  std::span<const uint32_t> _mappedIndicies;
+  GLuint _vertexCount = 0;
+  GLuint _indexCount = 0;
+  GLenum _indexType = GL_UNSIGNED_INT;
+  std::vector<meshLod> _lods;
+  glm::vec3 _boundingCenter = {0, 0, 0};
+  float _boundingRadius = 0;
+  glm::vec3 _boundsMin = {0, 0, 0};
+  glm::vec3 _boundsMax = {0, 0, 0};
+  MeshState _state = MeshState::Ready;
+  VertexFormat _format = VertexFormat::Full;
   glm::vec4 _color = {1,1,1,1};
 };
 
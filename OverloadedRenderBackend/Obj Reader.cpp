@@ -0,0 +1,177 @@
+#include "pch.h"
+#include "Obj Reader.h"
+#include "Mapped File.h"
+#include "Wermal Reader.h"
+#include <unordered_map>
+
+namespace
+{
+  // v/vt/vn indices of a face corner, already made 0 based, -1 when missing
+  struct Corner
+  {
+    int v, t, n;
+    bool operator==(Corner const&) const = default;
+  };
+
+  struct CornerHash
+  {
+    size_t operator()(Corner const& c) const
+    {
+      uint64_t h = static_cast<uint32_t>(c.v);
+      h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(c.t);
+      h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(c.n);
+      return static_cast<size_t>(h ^ (h >> 32));
+    }
+  };
+
+  // OBJ indices are 1 based, negative ones count back from the last element read
+  int ResolveIndex(std::string_view s, size_t count)
+  {
+    int i = 0;
+    if (s.empty() || Parse<int>(s, &i, 1) == 0 || i == 0)
+      return -1;
+    int resolved = i > 0 ? i - 1 : static_cast<int>(count) + i;
+    return resolved >= 0 && static_cast<size_t>(resolved) < count ? resolved : -1;
+  }
+
+  // Only the diffuse map of each material is of any use to us
+  void ReadMaterials(std::string const& path, std::unordered_map<std::string, std::string>& maps, std::string const& directory)
+  {
+    MappedFile file;
+    try
+    {
+      file = MappedFile(path);
+    }
+    catch (std::runtime_error const&)
+    {
+      return;
+    }
+    std::string_view rest = file.View();
+    std::string current;
+    while (!rest.empty())
+    {
+      size_t end = rest.find('\n');
+      std::string_view line = rest.substr(0, end);
+      rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+      std::string_view key = NextToken(line);
+      if (key == "newmtl")
+        current = NextToken(line);
+      else if (key == "map_Kd" && !current.empty())
+      {
+        // Options can come before the file name, the name is always last
+        std::string_view name;
+        for (std::string_view t = NextToken(line); !t.empty(); t = NextToken(line))
+          name = t;
+        maps[current] = directory + std::string(name);
+      }
+    }
+  }
+}
+
+ObjMesh ReadObj(std::string const& path)
+{
+  MappedFile file(path);
+  size_t slash = path.find_last_of("/\\");
+  return ReadObj(file.View(), slash == std::string::npos ? std::string() : path.substr(0, slash + 1));
+}
+
+ObjMesh ReadObj(std::string_view buffer, std::string const& directory)
+{
+  ObjMesh mesh;
+  std::vector<glm::vec4> positions;
+  std::vector<glm::vec4> colors;
+  std::vector<glm::vec2> uvs;
+  std::vector<glm::vec4> normals;
+  std::unordered_map<Corner, uint32_t, CornerHash> lookup;
+  std::unordered_map<std::string, std::string> materials;
+  std::vector<uint32_t> face;
+
+  // Rough guess from the size of the file so the big arrays grow only a few times
+  positions.reserve(buffer.size() / 64);
+  lookup.reserve(buffer.size() / 64);
+
+  std::string_view rest = buffer;
+  while (!rest.empty())
+  {
+    size_t end = rest.find('\n');
+    std::string_view line = rest.substr(0, end);
+    rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+
+    std::string_view key = NextToken(line);
+    if (key == "v")
+    {
+      // Some exporters append an RGB color after the position
+      float values[7] = { 0, 0, 0, 1, 1, 1, 1 };
+      size_t read = Parse<float>(line, values, 6);
+      positions.emplace_back(values[0], values[1], values[2], 1);
+      if (read == 6)
+        colors.emplace_back(values[3], values[4], values[5], 1);
+      else
+        colors.emplace_back(1, 1, 1, 1);
+    }
+    else if (key == "vt")
+    {
+      float values[2] = { 0, 0 };
+      Parse<float>(line, values, 2);
+      uvs.emplace_back(values[0], values[1]);
+    }
+    else if (key == "vn")
+    {
+      float values[3] = { 0, 0, 0 };
+      Parse<float>(line, values, 3);
+      normals.emplace_back(values[0], values[1], values[2], 0);
+    }
+    else if (key == "f")
+    {
+      face.clear();
+      for (std::string_view token = NextToken(line); !token.empty(); token = NextToken(line))
+      {
+        size_t first = token.find('/');
+        size_t second = first == std::string_view::npos ? std::string_view::npos : token.find('/', first + 1);
+        Corner c;
+        c.v = ResolveIndex(token.substr(0, first), positions.size());
+        c.t = first == std::string_view::npos ? -1 : ResolveIndex(token.substr(first + 1, second - first - 1), uvs.size());
+        c.n = second == std::string_view::npos ? -1 : ResolveIndex(token.substr(second + 1), normals.size());
+        if (c.v == -1)
+          continue;
+        if (c.n == -1)
+          mesh.hasNormals = false;
+
+        auto [it, inserted] = lookup.try_emplace(c, static_cast<uint32_t>(mesh.verticies.size()));
+        if (inserted)
+        {
+          Vertex v = {};
+          v.pos = positions[c.v];
+          v.color = colors[c.v];
+          if (c.n != -1)
+            v.normal = normals[c.n];
+          if (c.t != -1)
+            v.tex = uvs[c.t];
+          mesh.verticies.push_back(v);
+        }
+        face.push_back(it->second);
+      }
+      // Fan out polygons, fine for the convex faces exporters write
+      for (size_t i = 2; i < face.size(); ++i)
+      {
+        mesh.indices.push_back(face[0]);
+        mesh.indices.push_back(face[i - 1]);
+        mesh.indices.push_back(face[i]);
+      }
+    }
+    else if (key == "mtllib")
+    {
+      std::string_view name = NextToken(line);
+      ReadMaterials(directory + std::string(name), materials, directory);
+    }
+    else if (key == "usemtl" && mesh.texture.empty())
+    {
+      auto m = materials.find(std::string(NextToken(line)));
+      if (m != materials.end())
+        mesh.texture = m->second;
+    }
+  }
+  if (mesh.indices.empty())
+    mesh.hasNormals = false;
+  return mesh;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "Vertex.h"
+
+/**
+ * @brief Geometry read out of a Wavefront OBJ file.
+ *
+ * verticies - one Vertex per unique position/uv/normal index triple
+ * indices - triangle list (GL_TRIANGLES) into verticies, polygons are fan triangulated
+ * hasNormals - whether every face supplied normals, if not they still need to be calculated
+ * texture - the diffuse map of the first material used, relative to the working directory
+ */
+typedef struct ObjMesh
+{
+  std::vector<Vertex> verticies;
+  std::vector<uint32_t> indices;
+  bool hasNormals = true;
+  std::string texture;
+}ObjMesh;
+
+/**
+ * @brief Read an OBJ file.
+ *
+ * @param path the .obj file
+ * @return the mesh, throws std::runtime_error if the file can not be read
+ */
+ObjMesh ReadObj(std::string const& path);
+/**
+ * @brief Read OBJ data already in memory.
+ *
+ * @param buffer the contents of an .obj file
+ * @param directory where material libraries are looked up from
+ * @return the mesh
+ */
+ObjMesh ReadObj(std::string_view buffer, std::string const& directory);
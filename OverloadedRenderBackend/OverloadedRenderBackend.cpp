@@ -7,6 +7,7 @@
 #include "Mesh.h"
 #include "TexturedMesh.h"
 #include "Mesh Library.h"
+#include "Mesh Binary.h"
 #include "Fonts.h"
 
 enum class Errors : int
@@ -246,6 +247,36 @@ namespace orb
     active->EnableStoredRender(b);
   }
 
+  ORB_SPEC void EnableHotReload(bool b)
+  {
+    active->EnableHotReload(b);
+  }
+
+  ORB_SPEC void EnableMeshOptimization(bool b)
+  {
+    ORB_Mesh::optimizeMeshes = b;
+  }
+
+  ORB_SPEC void EnableMeshLOD(bool b)
+  {
+    ORB_Mesh::generateLods = b;
+  }
+
+  ORB_SPEC void SetNormalMode(NORMAL_MODE mode)
+  {
+    ORB_Mesh::normalMode = static_cast<NormalMode>(mode);
+  }
+
+  ORB_SPEC void EnableFrustumCulling(bool b)
+  {
+    ORB_Mesh::cullMeshes = b;
+  }
+
+  ORB_SPEC void EnableDrawSorting(bool b)
+  {
+    RenderQueue::sortDraws = b;
+  }
+
   ORB_SPEC Window *CreateNewWindow()
   {
     Window *w = active->MakeWindow();
@@ -402,18 +433,26 @@ namespace orb
   }
   ORB_SPEC void ORB_API DrawLine(Vector3D start, Vector3D end, int depth)
   {
-    if (active->Stored())
+    active->DrawLine(static_cast<glm::vec3>(start), static_cast<glm::vec3>(end), depth);
+  }
+  ORB_SPEC void ORB_API DrawPolyline(Vector3D const *points, int count, int depth)
+  {
+    if (points == nullptr || count < 2)
       return;
-    CheckError(__LINE__);
-    int oldActive = _activePolyMode - GL_POINT;
-    std::vector<Vertex> points = {
-        {glm::vec4(static_cast<glm::vec3>(start), 1), {1, 1, 1, 1}, {0, 0, 0, 0}, {0, 0}},
-        {glm::vec4(static_cast<glm::vec3>(end), 1), {1, 1, 1, 1}, {0, 0, 0, 0}, {0, 0}}};
-    active->SetMatrix(glm::identity<glm::mat4>());
-    active->SetFillMode(1);
-    const ORB_Mesh m = ORB_Mesh(GL_LINES, points, glm::vec4(1, 1, 1, 1));
-    active->DrawMesh(m, depth);
-    active->SetFillMode(oldActive);
+    // Reused so drawing lines every frame does not allocate
+    static std::vector<glm::vec3> converted;
+    converted.clear();
+    for (int i = 0; i < count; ++i)
+      converted.push_back({points[i].x, points[i].y, points[i].z});
+    active->DrawPolyline(converted, depth);
+  }
+  ORB_SPEC void ORB_API SetLineThickness(float thickness)
+  {
+    active->SetLineThickness(thickness);
+  }
+  ORB_SPEC void ORB_API SetLineJoin(LINE_JOIN join)
+  {
+    active->SetLineJoin(static_cast<LineJoin>(join));
   }
   ORB_SPEC void ORB_API SetFillMode(int i)
   {
@@ -469,8 +508,7 @@ namespace orb
   }
   ORB_SPEC void ORB_API SetUV(glm::mat4 const &uv)
   {
-
-    active->WriteUniform("texMulti", (void *)&uv);
+    active->SetUV(uv);
   }
   ORB_SPEC void ORB_API SetTextureSampleMode(ORB_texture t, SAMPLE_SCALE_MODE ssm)
   {
@@ -496,6 +534,16 @@ namespace orb
   {
     _activeMesh = MeshLibrary::Instance()->CreateTexMesh();
   }
+  ORB_SPEC void ORB_API BeginMesh(VERTEX_FORMAT format)
+  {
+    orb::BeginMesh();
+    _activeMesh->Format() = static_cast<VertexFormat>(format);
+  }
+  ORB_SPEC void ORB_API BeginTexMesh(VERTEX_FORMAT format)
+  {
+    orb::BeginTexMesh();
+    _activeMesh->Format() = static_cast<VertexFormat>(format);
+  }
   ORB_SPEC void ORB_API MeshSetDrawMode(int mode)
   {
     _activeMesh->DrawMode() = mode;
@@ -572,6 +620,35 @@ namespace orb
     _activeMesh = nullptr;
     return m;
   }
+  ORB_SPEC void ORB_API MeshSetDynamic()
+  {
+    _activeMesh->Dynamic() = true;
+  }
+  ORB_SPEC bool ORB_API MeshUpdateVertices(ORB_mesh m, int offset, int count, MeshVertex const *data)
+  {
+    if (m == nullptr || m->State() != MeshState::Ready || offset < 0 || count < 0 || (count > 0 && data == nullptr))
+      return false;
+    // Reused so updating every frame does not allocate
+    static std::vector<Vertex> converted;
+    converted.clear();
+    for (int i = 0; i < count; ++i)
+    {
+      MeshVertex const &v = data[i];
+      converted.push_back({{v.pos.x, v.pos.y, v.pos.z, 1}, {v.color.r, v.color.g, v.color.b, v.color.a}, {v.norm.r, v.norm.g, v.norm.b, v.norm.a}, {v.UV.x, v.UV.y}});
+    }
+    if (!const_cast<ORB_Mesh *>(m)->UpdateVerticies(offset, converted))
+    {
+      std::cerr << "ORB ERROR: Mesh update of verticies " << offset << " to " << offset + count << " is outside of the mesh" << std::endl;
+      return false;
+    }
+    return true;
+  }
+  ORB_SPEC void ORB_API MeshSetInstanceFormat(ORB_mesh m, INSTANCE_FORMAT format)
+  {
+    if (m == nullptr)
+      return;
+    const_cast<ORB_Mesh *>(m)->InstanceLayout(static_cast<InstanceFormat>(format));
+  }
   ORB_SPEC ORB_mesh ORB_API LoadMesh(const char *path)
   {
     ORB_mesh m = MeshLibrary::Instance()->CreateMesh(path);
@@ -595,6 +672,50 @@ namespace orb
     return MeshLibrary::Instance()->CreateTexMesh(s);
   }
 
+  ORB_SPEC bool ORB_API ConvertMesh(const char *source, const char *destination)
+  {
+    return ConvertMeshFile(source, destination);
+  }
+
+  ORB_SPEC ORB_mesh ORB_API LoadMeshAsync(const char *path)
+  {
+    return MeshLibrary::Instance()->CreateMeshAsync(path);
+  }
+
+  ORB_SPEC ORB_mesh ORB_API LoadMeshAsync(std::string &path)
+  {
+    return MeshLibrary::Instance()->CreateMeshAsync(path);
+  }
+
+  ORB_SPEC ORB_mesh ORB_API LoadTexMeshAsync(const char *path)
+  {
+    return MeshLibrary::Instance()->CreateTexMeshAsync(path);
+  }
+
+  ORB_SPEC ORB_mesh ORB_API LoadTexMeshAsync(std::string &path)
+  {
+    return MeshLibrary::Instance()->CreateTexMeshAsync(path);
+  }
+
+  ORB_SPEC MESH_STATE ORB_API MeshGetState(ORB_mesh m)
+  {
+    if (!m)
+      return MESH_STATE::MESH_FAILED;
+    return static_cast<MESH_STATE>(m->State());
+  }
+
+  ORB_SPEC void ORB_API DeleteMesh(ORB_mesh m)
+  {
+    if (_activeMesh == m)
+      _activeMesh = nullptr;
+    MeshLibrary::Instance()->DropMesh(const_cast<ORB_Mesh *>(m));
+  }
+
+  ORB_SPEC void ORB_API SetMeshCacheDirectory(const char *directory)
+  {
+    MeshLibrary::Instance()->SetCacheDirectory(directory ? directory : "");
+  }
+
   ORB_SPEC void ORB_API DrawMesh(const ORB_mesh m, Vector3D const &pos, Vector3D const &scale, Vector3D const &rot, int layer)
   {
     if (!m)
@@ -602,20 +723,25 @@ namespace orb
       std::cerr << "ORB ERROR: Attempted to draw non existant mesh" << std::endl;
       return;
     }
-    m->Execute();
+    // Stored draws bind each mesh's texture when they are drawn, and can come from threads without a GL context
+    if (!active->Stored())
+      m->Execute();
 
     active->SetMatrix({pos.x, pos.y, pos.z}, {scale.x, scale.y, scale.z}, {rot.x, rot.y, rot.z});
     if (m->Color() != glm::vec4(1, 1, 1, 1))
       active->SetColor(m->Color());
     active->DrawMesh((*m), (layer >= 0 ? layer : UINT_MAX - layer + 1));
-    SetUV(glm::identity<glm::mat4>());
+    // The UV matrix is shared render thread state, stored draws do not read it
+    if (!active->Stored())
+      SetUV(glm::identity<glm::mat4>());
   }
 
   ORB_SPEC void ORB_API DrawMesh(ORB_mesh m, glm::mat4 matrix, int layer)
   {
     active->SetMatrix(matrix);
     active->DrawMesh((*m), layer);
-    SetUV(glm::identity<glm::mat4>());
+    if (!active->Stored())
+      SetUV(glm::identity<glm::mat4>());
   }
 
   ORB_SPEC void ORB_API MeshSetLayer(ORB_mesh m, int l)
@@ -833,6 +959,36 @@ extern "C"
     orb::EnableStoredRender(b);
   }
 
+  ORB_SPEC void EnableHotReload(bool b)
+  {
+    orb::EnableHotReload(b);
+  }
+
+  ORB_SPEC void EnableMeshOptimization(bool b)
+  {
+    orb::EnableMeshOptimization(b);
+  }
+
+  ORB_SPEC void EnableMeshLOD(bool b)
+  {
+    orb::EnableMeshLOD(b);
+  }
+
+  ORB_SPEC void SetNormalMode(NORMAL_MODE mode)
+  {
+    orb::SetNormalMode(mode);
+  }
+
+  ORB_SPEC void EnableFrustumCulling(bool b)
+  {
+    orb::EnableFrustumCulling(b);
+  }
+
+  ORB_SPEC void EnableDrawSorting(bool b)
+  {
+    orb::EnableDrawSorting(b);
+  }
+
   ORB_SPEC void ORB_API RegisterRenderCallback(int (*Callback)(), RENDER_STAGE stage, int index)
   {
     orb::RegisterRenderCallback(Callback, stage, index);
@@ -954,6 +1110,21 @@ extern "C"
     orb::DrawLine(start, end, depth);
   }
 
+  ORB_SPEC void ORB_API DrawPolyline(Vector3D const *points, int count, int depth)
+  {
+    orb::DrawPolyline(points, count, depth);
+  }
+
+  ORB_SPEC void ORB_API SetLineThickness(float thickness)
+  {
+    orb::SetLineThickness(thickness);
+  }
+
+  ORB_SPEC void ORB_API SetLineJoin(LINE_JOIN join)
+  {
+    orb::SetLineJoin(join);
+  }
+
   ORB_SPEC void ORB_API SetProjectionMode(PROJECTION_TYPE p)
   {
     orb::SetProjectionMode(p);
@@ -1039,6 +1210,16 @@ extern "C"
     orb::BeginTexMesh();
   }
 
+  ORB_SPEC void ORB_API BeginMeshWithFormat(VERTEX_FORMAT format)
+  {
+    orb::BeginMesh(format);
+  }
+
+  ORB_SPEC void ORB_API BeginTexMeshWithFormat(VERTEX_FORMAT format)
+  {
+    orb::BeginTexMesh(format);
+  }
+
   ORB_SPEC void ORB_API MeshSetDrawMode(int mode)
   {
     orb::MeshSetDrawMode(mode);
@@ -1069,6 +1250,21 @@ extern "C"
     return orb::EndMesh();
   }
 
+  ORB_SPEC void ORB_API MeshSetDynamic()
+  {
+    orb::MeshSetDynamic();
+  }
+
+  ORB_SPEC bool ORB_API MeshUpdateVertices(ORB_mesh m, int offset, int count, MeshVertex const *data)
+  {
+    return orb::MeshUpdateVertices(m, offset, count, data);
+  }
+
+  ORB_SPEC void ORB_API MeshSetInstanceFormat(ORB_mesh m, INSTANCE_FORMAT format)
+  {
+    orb::MeshSetInstanceFormat(m, format);
+  }
+
   ORB_SPEC ORB_mesh ORB_API LoadMesh(const char *c)
   {
     return orb::LoadMesh(c);
@@ -1079,6 +1275,36 @@ extern "C"
     return orb::LoadTexMesh(c);
   }
 
+  ORB_SPEC bool ORB_API ConvertMesh(const char *source, const char *destination)
+  {
+    return orb::ConvertMesh(source, destination);
+  }
+
+  ORB_SPEC ORB_mesh ORB_API LoadMeshAsync(const char *path)
+  {
+    return orb::LoadMeshAsync(path);
+  }
+
+  ORB_SPEC ORB_mesh ORB_API LoadTexMeshAsync(const char *path)
+  {
+    return orb::LoadTexMeshAsync(path);
+  }
+
+  ORB_SPEC MESH_STATE ORB_API MeshGetState(ORB_mesh m)
+  {
+    return orb::MeshGetState(m);
+  }
+
+  ORB_SPEC void ORB_API DeleteMesh(ORB_mesh m)
+  {
+    orb::DeleteMesh(m);
+  }
+
+  ORB_SPEC void ORB_API SetMeshCacheDirectory(const char *directory)
+  {
+    orb::SetMeshCacheDirectory(directory);
+  }
+
   ORB_SPEC void ORB_API DrawMesh(ORB_mesh m, Vector3D const *pos, Vector3D const *scale, Vector3D const *rot, int layer)
   {
     orb::DrawMesh(m, *pos, *scale, *rot, layer);
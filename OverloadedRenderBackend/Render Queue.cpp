@@ -0,0 +1,96 @@
+#include "pch.h"
+#include "Render Queue.h"
+
+bool RenderQueue::sortDraws = true;
+
+namespace
+{
+  // Keep the low bits of a value that has to fit in a field of the key
+  constexpr uint64_t Field(uint64_t value, int bits)
+  {
+    return std::min(value, (uint64_t(1) << bits) - 1);
+  }
+
+  // Map a depth in normalized device coordinates to 16 bits, 0 is the near plane
+  uint64_t QuantizeDepth(float viewDepth)
+  {
+    float depth = std::clamp(viewDepth * 0.5f + 0.5f, 0.f, 1.f);
+    return static_cast<uint64_t>(depth * 65535.f);
+  }
+}
+
+void RenderQueue::Add(queuedDraw const& draw, float viewDepth, bool transparent)
+{
+  uint32_t index = static_cast<uint32_t>(_draws.size());
+  _draws.push_back(draw);
+  queuedDraw& queued = _draws.back();
+  // Draws without a layer go wherever the draw before them went
+  if (queued.depth == UINT_MAX)
+    queued.depth = _lastDepth;
+  else
+    _lastDepth = queued.depth;
+
+  if (!sortDraws)
+  {
+    _entries.push_back({0, index});
+    return;
+  }
+  // Draws that bind nothing come first, they go to what was bound before the queue
+  uint64_t layer = queued.depth == UINT_MAX ? 0 : Field(uint64_t(queued.depth) + 1, 8);
+  uint64_t state = Field(queued.blend, 3) << 2 | Field(queued.fill, 2);
+  uint64_t depth = QuantizeDepth(viewDepth);
+  uint64_t key = layer << 56 | uint64_t(transparent) << 55 | state << 50;
+  key |= (transparent ? 0xFFFF - depth : depth) << 34;
+  // Opaque meshes at the same depth are resolved by the depth test, only rects and blended draws need call order
+  if (!transparent && queued.mesh != nullptr)
+    key |= (TextureID(queued.texture) + 1) << 12 | Field(queued.material, 12);
+  _entries.push_back({key, index});
+}
+
+void RenderQueue::Sort()
+{
+  _order.clear();
+  if (_entries.empty())
+    return;
+  _scratch.resize(_entries.size());
+  // Least significant byte first, each pass is stable so the earlier ones hold within equal bytes
+  for (int shift = 0; shift < 64; shift += 8)
+  {
+    size_t counts[256] = {};
+    for (auto const& entry : _entries)
+      ++counts[(entry.key >> shift) & 0xFF];
+    // Every key has the same byte here, the pass would not move anything
+    if (counts[(_entries.front().key >> shift) & 0xFF] == _entries.size())
+      continue;
+    size_t offset = 0;
+    for (auto& count : counts)
+    {
+      size_t c = count;
+      count = offset;
+      offset += c;
+    }
+    for (auto const& entry : _entries)
+      _scratch[counts[(entry.key >> shift) & 0xFF]++] = entry;
+    _entries.swap(_scratch);
+  }
+  for (size_t i = 0; i < _entries.size(); ++i)
+    _order.push_back(_entries[i].index);
+}
+
+void RenderQueue::Clear()
+{
+  _draws.clear();
+  _entries.clear();
+  _order.clear();
+  _textures.clear();
+  _lastDepth = UINT_MAX;
+}
+
+uint64_t RenderQueue::TextureID(ORB_Texture* texture)
+{
+  auto found = std::find(_textures.begin(), _textures.end(), texture);
+  if (found != _textures.end())
+    return Field(found - _textures.begin(), 21);
+  _textures.push_back(texture);
+  return Field(_textures.size() - 1, 21);
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm.hpp>
+
+class ORB_Mesh;
+struct ORB_Texture;
+
+/**
+ * @brief One immediate draw and the state it was called with.
+ *
+ * mesh - the mesh to draw, nullptr for a rect
+ * lod - the level of detail picked for the mesh
+ * depth - the layer it draws to, UINT_MAX to draw to whatever is bound
+ * blend - the blend mode, see Renderer::SetBlendMode
+ * fill - the polygon mode
+ * texture - the active texture, nullptr for none
+ * material - the index of the material in Renderer::_materials
+ * matrix, normalMatrix - the object matrices
+ * color - the global color
+ * uv - the texture coordinate matrix
+ */
+typedef struct queuedDraw
+{
+  ORB_Mesh const* mesh;
+  int lod;
+  unsigned int depth;
+  int blend;
+  unsigned int fill;
+  ORB_Texture* texture;
+  int material;
+  glm::mat4 matrix;
+  glm::mat4 normalMatrix;
+  glm::vec4 color;
+  glm::mat4 uv;
+}queuedDraw;
+
+/**
+ * @brief Records immediate draws so they can be submitted sorted by the state they need.
+ *
+ * @details Every draw gets a 64 bit key, from the most significant bits down:
+ * layer (8), transparent (1), blend (3), fill (2), depth (16), texture (22), material (12).
+ * Transparent draws store the depth inverted, so they are drawn back to front after the opaque draws of their
+ * layer, opaque draws go front to back. Only opaque meshes fill in texture and material, the depth test decides
+ * which of them shows, so meshes at the same depth are grouped by the texture and material they bind. Rects all
+ * sit at the same depth and overlap by call order, they and transparent draws leave both at 0. The keys are radix
+ * sorted, which is stable, so draws with the same key keep the order they were called in.
+ */
+class RenderQueue
+{
+public:
+  // Sort draws by their key, when false draws are submitted in the order they were called in
+  static bool sortDraws;
+
+  /**
+   * @brief Queue a draw.
+   *
+   * @param draw the draw, a depth of UINT_MAX is replaced with the layer of the last draw that had one
+   * @param viewDepth the depth of the draw's origin in normalized device coordinates
+   * @param transparent whether it blends with what is behind it
+   */
+  void Add(queuedDraw const& draw, float viewDepth, bool transparent);
+  /**
+   * @brief Sort the queued draws, Order is only valid after this.
+   */
+  void Sort();
+
+  bool Empty() const { return _draws.empty(); }
+  std::vector<queuedDraw> const& Draws() const { return _draws; }
+  /**
+   * @brief The indicies of the draws in the order they should be submitted.
+   */
+  std::vector<uint32_t> const& Order() const { return _order; }
+  /**
+   * @brief The layer the last draw that picked one was called with, UINT_MAX if none did.
+   */
+  unsigned int LastDepth() const { return _lastDepth; }
+  void Clear();
+
+private:
+  typedef struct sortEntry
+  {
+    uint64_t key;
+    uint32_t index;
+  }sortEntry;
+
+  // Small ids for the textures in the queue, in the order they were first seen
+  uint64_t TextureID(ORB_Texture* texture);
+
+  std::vector<queuedDraw> _draws;
+  std::vector<sortEntry> _entries;
+  std::vector<sortEntry> _scratch;
+  std::vector<uint32_t> _order;
+  std::vector<ORB_Texture*> _textures;
+  unsigned int _lastDepth = UINT_MAX;
+};
@@ -8,12 +8,14 @@
 #include "pch.h"
 #include "RenderBackend.h"
 #include "RenderPass.h"
+#include "ShaderStage.h"
 #include "Textures.h"
 #include "Vertex.h"
 #define GLM_ENABLE_EXPERIMENTAL
 #include <gtx/string_cast.hpp>
 #define LOG_WINDOW_SWAPS 0
 #include "Mesh Library.h"
+#include "File Watcher.h"
 // Used for sending ponter to value containing true or false
 const int zero = 0;
 const int one = 1;
@@ -225,6 +227,8 @@ Window *Renderer::MakeWindow(std::string s)
 
 void Renderer::SetActiveWindow(Window *w)
 {
+  BreakQueue();
+  FlushLines();
   if (activeWindows.size() > 1)
     glFlush();
 #if LOG_WINDOW_SWAPS
@@ -328,6 +332,16 @@ void Renderer::LoadRenderPass(std::string path)
 void Renderer::LoadRenderPass(const char *path)
 {
   local = this;
+  BreakQueue();
+  // The line stage goes away with the old pass
+  FlushLines();
+  // Loading the same pass again only rebuilds what changed, the FBOs and untouched stages stay
+  if (_activePass != nullptr && custom && _activePass->Path() == path)
+  {
+    _activePass->Reload();
+    WatchPass();
+    return;
+  }
   custom = true;
   // TODO: Make this check for API version
 
@@ -339,10 +353,55 @@ void Renderer::LoadRenderPass(const char *path)
   {
     w->VAO = "";
   }
+  WatchPass();
+}
+
+void Renderer::EnableHotReload(bool value)
+{
+  if (value == (_watcher != nullptr))
+    return;
+  if (value)
+  {
+    _watcher = new FileWatcher();
+    WatchPass();
+    MeshLibrary::Instance()->SetWatcher(_watcher);
+  }
+  else
+  {
+    MeshLibrary::Instance()->SetWatcher(nullptr);
+    delete _watcher;
+    _watcher = nullptr;
+  }
+}
+
+void Renderer::WatchPass()
+{
+  if (_watcher == nullptr)
+    return;
+  for (auto &file : _activePass->Files())
+    _watcher->Watch(file);
+}
+
+void Renderer::HotReload()
+{
+  for (auto &file : _watcher->Changes())
+  {
+    if (FileWatcher::Normalize(_activePass->Path()) == file)
+    {
+      _activePass->Reload();
+      WatchPass();
+      continue;
+    }
+    // Stages can pick up new sources, so they get watched again
+    if (_activePass->ReloadStage(file))
+      WatchPass();
+    MeshLibrary::Instance()->Reload(file);
+  }
 }
 
 void Renderer::WriteBuffer(std::string buffer, size_t dataSize, void *data)
 {
+  BreakQueue();
   _activePass->BindBuffer(buffer);
   _activePass->WriteBuffer(buffer, dataSize, data);
   _activePass->UnBindBuffer(buffer);
@@ -350,6 +409,7 @@ void Renderer::WriteBuffer(std::string buffer, size_t dataSize, void *data)
 
 void Renderer::WriteUniform(std::string uniform, void *data)
 {
+  BreakQueue();
   _activePass->WriteAttribute(uniform, data);
 }
 
@@ -362,11 +422,13 @@ glm::vec2 Renderer::ToWorldSpace(glm::vec2 src)
 
 void Renderer::SetBufferBase(std::string buffer, int base)
 {
+  BreakQueue();
   _activePass->SetBufferBase(buffer, base);
 }
 
 void Renderer::WriteSubBufferData(std::string s, int index, size_t structSize, void *data)
 {
+  BreakQueue();
   _activePass->BindBuffer(s);
   _activePass->WriteSubBufferData(s, index, structSize, data);
   _activePass->UnBindBuffer(s);
@@ -374,6 +436,7 @@ void Renderer::WriteSubBufferData(std::string s, int index, size_t structSize, v
 
 void Renderer::DispatchCompute(int x, int y, int z)
 {
+  BreakQueue();
   _activePass->DispatchCompute(x, y, z);
 }
 
@@ -416,6 +479,9 @@ void Renderer::WriteRenderConstantsHere()
     _storedProjection = _projectionMatrix * camMat;
     break;
   }
+  // The zoom scales w along with everything else, so it does not change what is on screen
+  _screenFrustum = Frustum::FromMatrix(_projectionMatrix);
+  _storedFrustum = Frustum::FromMatrix(_storedProjection);
   _activePass->WriteAttribute("screenMatrix", &_storedProjection[0][0]);
   _activePass->WriteAttribute("zoom", &_zoom);
   if (_activePass->QuerryAttribute("texMulti"))
@@ -430,6 +496,47 @@ void Renderer::SetBindings(GLuint b, GLuint VAO)
   _activePass->SetBindings(b, VAO);
 }
 
+std::vector<vertexAttribute> const &Renderer::VertexLayout()
+{
+  return _activePass->VertexLayout();
+}
+
+size_t Renderer::VertexStride()
+{
+  return _activePass->VertexStride();
+}
+
+int Renderer::SelectLod(ORB_Mesh const &v, glm::mat4 const &model, glm::mat4 const &projection) const
+{
+  if (v.Lods().empty())
+    return 0;
+  // Same math as the vertex shader, the zoom scales w as well so it only matters for perspective
+  glm::vec4 clip = projection * (model * glm::vec4(v.BoundingCenter(), 1) * _zoom);
+  float scale = std::max({glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))});
+  float radius = v.BoundingRadius() * scale * _zoom;
+  // How many pixels one unit at the center covers, from the rows of the projection that make x and y
+  float pixelsX = glm::length(glm::vec3(projection[0][0], projection[1][0], projection[2][0])) * _windowSize.x * 0.5f;
+  float pixelsY = glm::length(glm::vec3(projection[0][1], projection[1][1], projection[2][1])) * _windowSize.y * 0.5f;
+  float w = std::max(std::abs(clip.w), 1e-6f);
+  return v.SelectLod(radius * std::max(pixelsX, pixelsY) / w);
+}
+
+void Renderer::SetVertexFormat(VertexFormat format)
+{
+  if (_activePass->QuerryAttribute("octNormals") == false)
+    return;
+  int oct = format == VertexFormat::Compact;
+  _activePass->WriteAttribute("octNormals", &oct);
+}
+
+void Renderer::SetInstanceFormat(InstanceFormat format)
+{
+  if (_activePass->QuerryAttribute("instanceFormat") == false)
+    return;
+  int value = static_cast<int>(format);
+  _activePass->WriteAttribute("instanceFormat", &value);
+}
+
 glm::vec2 Renderer::ToScreenSpace(glm::vec2 src)
 {
   auto screenSize = glm::vec2(_window->w, _window->h);
@@ -444,74 +551,124 @@ void Renderer::RegisterCallBack(int stage, int id, renderCallBack fn)
 
 void Renderer::DrawRect(glm::vec2 pos, glm::vec2 scale, float rot, uint depth)
 {
-  if (Stored())
-    return;
-  if (depth != UINT_MAX)
-  {
-    if (_window->primary == true)
-    {
-      _activePass->BindActiveFBO(depth);
-      if (depth == 2)
-      {
-        _activePass->WriteAttribute("screenMatrix", &_projectionMatrix[0][0]);
-      }
-    }
-    else
-    {
-      _activePass->BindActiveFBO(-1);
-    }
-  }
-  if (_window->VAO == "")
-  {
-    _window->VAO = _activePass->MakeVAO(_window->name + "VAO");
-  }
-  if (_activePass->HasVAO(_window->VAO) == false)
+  // The matrix SetMatrix would build, the rect keeps it instead of writing it to the stage
+  glm::mat4 matrix = glm::translate(glm::identity<glm::mat4>(), glm::vec3(pos, -1750));
+  matrix = glm::rotate(matrix, rot, glm::vec3(0, 0, 1));
+  matrix = glm::scale(matrix, glm::vec3(scale, 1));
+  if (storedRender)
   {
-    _activePass->MakeVAO(_window->VAO);
+    _sprites.Add(_activeTexture, depth, matrix, SubmissionContext::Local().color, _uvMatrix);
+    return;
   }
-  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+  QueueDraw(nullptr, 0, depth, matrix, depth == 2 && _window->primary ? _projectionMatrix : _storedProjection);
+}
+
+void Renderer::FlushSprites()
+{
+  if (_sprites.Empty())
     return;
-  SetMatrix({pos, -1750}, {scale, 0}, {rot, 0, 0});
-  std::vector<Vertex> mesh = {
-      {{-.5f, -.5f, 0, 1}, {1, 1, 1, 1}, {0, 0, 1, 0}, {0, 1}},
-      {{.5f, -.5f, 0, 1}, {1, 1, 1, 1}, {0, 0, 1, 0}, {1, 1}},
-      {{.5f, .5f, 0, 1}, {1, 1, 1, 1}, {0, 0, 1, 0}, {1, 0}},
-      {{-.5f, .5f, 0, 1}, {1, 1, 1, 1}, {0, 0, 1, 0}, {0, 0}},
+  auto write = [this](const char *name, void const *data)
+  {
+    if (_activePass->QuerryAttribute(name))
+      _activePass->WriteAttribute(name, const_cast<void *>(data));
   };
-  const ORB_Mesh m = ORB_Mesh(GL_TRIANGLE_FAN, mesh, glm::vec4(1, 1, 1, 1));
+  std::optional<ORB_Texture *> texture;
+  DrawSprites(texture);
 
-  glBindVertexArray(m.VAO());
-  glBindBuffer(GL_ARRAY_BUFFER, m.Buffer());
-  glDrawArrays(m.DrawMode(), 0, static_cast<int>(m.Size()));
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
-  if (depth == 2)
-    _activePass->WriteAttribute("screenMatrix", &_storedProjection[0][0]);
+  // Stages without textures never had one bound for their rects
+  if (_activePass->QuerryAttribute("textured") && _activePass->QuerryAttribute("tex"))
+    BindTexture(_activeTexture);
+  if (!storedRender)
+  {
+    write("objectMatrix", &_currentObject.matrix);
+    write("normalMatrix", &_currentObject.normalMatrix);
+    write("globalColor", &_color);
+    write("texMulti", &_uvMatrix);
+  }
 }
 
-void Renderer::DrawMesh(ORB_Mesh const &v, uint depth)
+void Renderer::DrawSprites(std::optional<ORB_Texture *> &texture)
 {
+  if (_sprites.Empty())
+    return;
+  auto write = [this](const char *name, void const *data)
+  {
+    if (_activePass->QuerryAttribute(name))
+      _activePass->WriteAttribute(name, const_cast<void *>(data));
+  };
+  // The rects already have their transform, color and UVs, the stage gets ones that leave them alone
+  glm::mat4 const identity = glm::identity<glm::mat4>();
+  glm::vec4 const white = {1, 1, 1, 1};
   if (storedRender)
   {
-    const_cast<ORB_Mesh &>(v).AddCall(_currentObject);
-    return;
+    affineInstance info = AffineInstance(identity, white, 0);
+    SetInstanceFormat(InstanceFormat::Affine);
+    _instances.Write(0, &info, sizeof(affineInstance));
   }
-  if (depth != UINT_MAX)
+  else
   {
-    if (_window->primary == true)
-    {
-      _activePass->BindActiveFBO(depth);
-      if (depth == 2)
-      {
-        _activePass->WriteAttribute("screenMatrix", &_projectionMatrix[0][0]);
-      }
-    }
-    else
+    write("objectMatrix", &identity);
+    write("normalMatrix", &identity);
+    write("globalColor", &white);
+    write("texMulti", &identity);
+  }
+  SetVertexFormat(VertexFormat::Full);
+  _sprites.Upload(VertexLayout(), VertexStride());
+
+  bool textured = _activePass->QuerryAttribute("textured") && _activePass->QuerryAttribute("tex");
+  for (auto const &run : _sprites.Runs())
+  {
+    bool screen = run.depth == 2 && _window->primary;
+    // Stored rects go where the stored meshes go
+    if (!storedRender && run.depth != UINT_MAX)
+      _activePass->BindActiveFBO(_window->primary ? static_cast<int>(run.depth) : -1);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+      continue;
+    if (screen)
+      write("screenMatrix", &_projectionMatrix[0][0]);
+    if (textured && (!texture || *texture != run.texture))
     {
-      _activePass->BindActiveFBO(-1);
+      BindTexture(run.texture);
+      texture = run.texture;
     }
+    _sprites.Draw(run);
+    if (screen)
+      write("screenMatrix", &_storedProjection[0][0]);
   }
+  _sprites.Clear();
+}
+
+void Renderer::QueueDraw(ORB_Mesh const *mesh, int lod, uint depth, glm::mat4 const &matrix, glm::mat4 const &projection)
+{
+  glm::vec4 clip = projection * (matrix[3] * _zoom);
+  float viewDepth = clip.z / std::max(std::abs(clip.w), 1e-6f);
+  // Texture alpha is not known here, blended draws that are textured or not fully opaque are drawn back to front
+  bool transparent = _blendMode != 0 && (_color.a < 1 || _activeTexture != nullptr);
+  queuedDraw draw = {
+      .mesh = mesh,
+      .lod = lod,
+      .depth = depth,
+      .blend = _blendMode,
+      .fill = _activePolyMode - GL_POINT,
+      .texture = _activeTexture,
+      .material = _currentObject.materialID,
+      .matrix = matrix,
+      .normalMatrix = _currentObject.normalMatrix,
+      .color = _color,
+      .uv = _uvMatrix,
+  };
+  _queue.Add(draw, viewDepth, transparent);
+}
 
+void Renderer::FlushQueue()
+{
+  if (_queue.Empty())
+    return;
+  auto write = [this](const char *name, void const *data)
+  {
+    if (_activePass->QuerryAttribute(name))
+      _activePass->WriteAttribute(name, const_cast<void *>(data));
+  };
   if (_window->VAO == "")
   {
     _window->VAO = _activePass->MakeVAO(_window->name + "VAO");
@@ -520,25 +677,185 @@ void Renderer::DrawMesh(ORB_Mesh const &v, uint depth)
   {
     _activePass->MakeVAO(_window->VAO);
   }
-  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+  _queue.Sort();
+
+  // What is bound now, only what a draw changes is sent to GL
+  unsigned int depth = UINT_MAX;
+  bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+  bool screen = false;
+  int blend = _blendMode;
+  unsigned int fill = _activePolyMode - GL_POINT;
+  bool textured = _activePass->QuerryAttribute("textured") && _activePass->QuerryAttribute("tex");
+  std::optional<ORB_Texture *> texture;
+  std::optional<int> material;
+  for (uint32_t index : _queue.Order())
+  {
+    queuedDraw const &draw = _queue.Draws()[index];
+    bool rect = draw.mesh == nullptr;
+    // Rects in a row are drawn together until a mesh or the state they share changes
+    if (!rect || draw.depth != depth || draw.blend != blend || draw.fill != fill)
+      DrawSprites(texture);
+    if (draw.depth != depth && draw.depth != UINT_MAX)
+    {
+      depth = draw.depth;
+      _activePass->BindActiveFBO(_window->primary ? static_cast<int>(depth) : -1);
+      complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+      bool layerScreen = depth == 2 && _window->primary;
+      if (layerScreen != screen)
+        write("screenMatrix", layerScreen ? &_projectionMatrix[0][0] : &_storedProjection[0][0]);
+      screen = layerScreen;
+    }
+    // Nothing drawn to the layer would end up anywhere
+    if (!complete)
+      continue;
+    if (draw.blend != blend)
+      ApplyBlendMode(blend = draw.blend);
+    if (draw.fill != fill)
+      glPolygonMode(GL_FRONT_AND_BACK, GL_POINT + (fill = draw.fill));
+    if (rect)
+    {
+      // The layer is already bound, the run only has to bind its texture
+      _sprites.Add(draw.texture, UINT_MAX, draw.matrix, draw.color, draw.uv);
+      continue;
+    }
+
+    if (textured && (!texture || *texture != draw.texture))
+    {
+      BindTexture(draw.texture);
+      texture = draw.texture;
+    }
+    if (!material || *material != draw.material)
+    {
+      WriteMaterial(draw.material);
+      material = draw.material;
+    }
+    write("objectMatrix", &draw.matrix);
+    write("normalMatrix", &draw.normalMatrix);
+    write("globalColor", &draw.color);
+    write("texMulti", &draw.uv);
+    SetVertexFormat(draw.mesh->Format());
+    glBindVertexArray(draw.mesh->VAO());
+    draw.mesh->Draw(draw.lod);
+    glBindVertexArray(0);
+  }
+  DrawSprites(texture);
+
+  // Draws after the queue see the state they were set up with
+  if (screen)
+    write("screenMatrix", &_storedProjection[0][0]);
+  if (blend != _blendMode)
+    ApplyBlendMode(_blendMode);
+  if (fill != _activePolyMode - GL_POINT)
+    glPolygonMode(GL_FRONT_AND_BACK, _activePolyMode);
+  if (textured && texture && *texture != _activeTexture)
+    BindTexture(_activeTexture);
+  if (material && *material != _currentObject.materialID)
+    WriteMaterial(_currentObject.materialID);
+  write("objectMatrix", &_currentObject.matrix);
+  write("normalMatrix", &_currentObject.normalMatrix);
+  write("globalColor", &_color);
+  write("texMulti", &_uvMatrix);
+  // Draws without a layer go where the last draw that had one went
+  unsigned int last = _queue.LastDepth();
+  if (last != UINT_MAX && last != depth)
+    _activePass->BindActiveFBO(_window->primary ? static_cast<int>(last) : -1);
+  _queue.Clear();
+}
+
+void Renderer::DrawLine(glm::vec3 const &start, glm::vec3 const &end, uint depth)
+{
+  glm::vec3 const points[2] = {start, end};
+  DrawPolyline(points, depth);
+}
+
+void Renderer::DrawPolyline(std::span<glm::vec3 const> points, uint depth)
+{
+  // Stored mode keeps the color SetColor picked in the calling thread's context
+  glm::vec4 const &color = storedRender ? SubmissionContext::Local().color : _color;
+  _lines.Add(points, color, _lineThickness, _lineJoin, depth);
+}
+
+void Renderer::SetLineThickness(float thickness)
+{
+  _lineThickness = thickness;
+}
+
+void Renderer::SetLineJoin(LineJoin join)
+{
+  _lineJoin = join;
+}
+
+void Renderer::FlushLines()
+{
+  if (_lines.Empty())
     return;
+  ShaderStage *stage = _activePass->LineStage();
+  // The stage that was running carries on after the lines
+  GLint program = 0;
+  glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+  GLboolean culling = glIsEnabled(GL_CULL_FACE);
+  glDisable(GL_CULL_FACE);
+  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+  // Thickness is in pixels, so the stage needs to know how many there are
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  glm::vec2 size = {viewport[2], viewport[3]};
+  stage->WriteAttribute("viewport", &size);
+  stage->WriteAttribute("zoom", &_zoom);
+  _lines.Upload();
+  for (auto const &run : _lines.Runs())
+  {
+    bool screen = run.depth == 2 && _window->primary;
+    if (!storedRender && run.depth != UINT_MAX)
+      _activePass->BindActiveFBO(_window->primary ? static_cast<int>(run.depth) : -1);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+      continue;
+    stage->WriteAttribute("screenMatrix", screen ? &_projectionMatrix[0][0] : &_storedProjection[0][0]);
+    _lines.Draw(run);
+  }
+  _lines.Clear();
 
-  glBindVertexArray(v.VAO());
-  glBindBuffer(GL_ARRAY_BUFFER, v.Buffer());
-  glDrawArrays(v.DrawMode(), 0, static_cast<int>(v.Size()));
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
-  if (depth == 2)
-    _activePass->WriteAttribute("screenMatrix", &_storedProjection[0][0]);
+  glPolygonMode(GL_FRONT_AND_BACK, _activePolyMode);
+  if (culling)
+    glEnable(GL_CULL_FACE);
+  glUseProgram(program);
+}
+
+void Renderer::BreakQueue()
+{
+  if (!storedRender)
+    FlushQueue();
+}
+
+void Renderer::DrawMesh(ORB_Mesh const &v, uint depth)
+{
+  // Meshes still loading (or that failed to) have nothing to draw
+  if (v.State() != MeshState::Ready)
+    return;
+  if (storedRender)
+  {
+    // Each thread stages its own calls, StoredUpdate hands them to the meshes
+    SubmissionContext &context = SubmissionContext::Local();
+    context.Add(const_cast<ORB_Mesh *>(&v), SelectLod(v, context.matrix, _storedProjection));
+    return;
+  }
+  // Nothing of it would end up on screen
+  bool screen = depth == 2 && _window->primary;
+  if (ORB_Mesh::cullMeshes && !v.Visible(screen ? _screenFrustum : _storedFrustum, _currentObject.matrix))
+    return;
+  glm::mat4 const &projection = screen ? _projectionMatrix : _storedProjection;
+  QueueDraw(&v, SelectLod(v, _currentObject.matrix, projection), depth, _currentObject.matrix, projection);
 }
 
 void Renderer::SetColor(glm::vec4 const &color)
 {
   if (storedRender)
   {
-    _currentObject.color = color;
+    SubmissionContext::Local().color = color;
     return;
   }
+  _color = color;
 
   if (_activePass->QuerryAttribute("globalColor") == false)
   {
@@ -561,11 +878,15 @@ void Renderer::SetMatrix(glm::vec3 const &pos, glm::vec3 const &scale, float rot
 
 void Renderer::DrawIndexed(ORB_Mesh const &v, int count)
 {
+  if (v.State() != MeshState::Ready)
+    return;
   if (storedRender)
   {
-    const_cast<ORB_Mesh &>(v).AddCall(_currentObject);
+    SubmissionContext &context = SubmissionContext::Local();
+    context.Add(const_cast<ORB_Mesh *>(&v), SelectLod(v, context.matrix, _storedProjection));
     return;
   }
+  BreakQueue();
 
   if (_window->primary == true)
   {
@@ -586,10 +907,9 @@ void Renderer::DrawIndexed(ORB_Mesh const &v, int count)
   }
   if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
     return;
+  SetVertexFormat(v.Format());
   glBindVertexArray(v.VAO());
-  glBindBuffer(GL_ARRAY_BUFFER, v.Buffer());
-  glDrawArraysInstanced(v.DrawMode(), 0, static_cast<int>(v.Size()), count);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  v.Draw(SelectLod(v, _currentObject.matrix, _storedProjection), count);
   glBindVertexArray(0);
 }
 
@@ -604,14 +924,17 @@ void Renderer::SetMatrix(glm::vec3 const &pos, glm::vec3 const &scale, glm::vec3
   temp = glm::rotate(temp, rot.y, glm::vec3(1, 0, 0));
   temp = glm::rotate(temp, rot.z, glm::vec3(0, 1, 0));
   temp = glm::scale(temp, sca);
-  glm::mat3 inv = glm::inverse(glm::mat3(temp));
-  glm::mat4 norm = glm::mat4(glm::transpose(inv));
+  // Stored calls work out the normal matrix on the GPU
   if (storedRender)
   {
-    _currentObject.matrix = temp;
-    _currentObject.normalMatrix = norm;
+    SubmissionContext::Local().matrix = temp;
     return;
   }
+  // Immediate draws still read the matrices back to pick a level of detail and after drawing rects
+  _currentObject.matrix = temp;
+  glm::mat3 inv = glm::inverse(glm::mat3(temp));
+  glm::mat4 norm = glm::mat4(glm::transpose(inv));
+  _currentObject.normalMatrix = norm;
 
   if (_activePass->QuerryAttribute("objectMatrix") == false)
   {
@@ -632,6 +955,7 @@ void Renderer::SetMatrix(glm::vec3 const &pos, glm::vec3 const &scale, glm::vec3
 
 void Renderer::EnableLighting(bool value)
 {
+  BreakQueue();
   enableLighting = value;
 }
 int StoredUpdate()
@@ -639,18 +963,49 @@ int StoredUpdate()
   std::vector<ORB_Mesh *> const &meshes = MeshLibrary::Instance()->GetMeshes();
   std::string fbo = "Primary 1";
   local->BindActiveFBO(local->GetFBOByName(fbo));
-  local->SetBufferBase("RenderBuffer", 0);
-  local->SetBufferBase("MaterialBuffer",1);
-  local->WriteBuffer("MaterialBuffer", sizeof(Renderer::MaterialInfo) * local->_materials.size(), local->_materials.data());
+  // Every mesh's calls go into this frame's region, RenderBuffer is bound to each block as it is drawn
+  local->Instances().BeginFrame();
+  // Every thread's calls go to their meshes before they are culled and drawn
+  SubmissionContext::Merge();
+  // Only materials added since the last frame are sent
+  local->_materials.Upload(1);
+  local->DrawStored(meshes);
+  local->FlushSprites();
+  local->Instances().EndFrame();
+  local->FlushLines();
+  return 0;
+}
+void Renderer::DrawStored(std::vector<ORB_Mesh *> const &meshes)
+{
   for (auto &mesh : meshes)
   {
-    mesh->Render();
+    // Instances that are off screen never make it into the render buffer
+    if (ORB_Mesh::cullMeshes)
+      mesh->Cull(_storedFrustum);
+    _indirect.Add(*mesh);
     mesh->Reset();
   }
-  return 0;
+  bool textured = _activePass->QuerryAttribute("textured") && _activePass->QuerryAttribute("tex");
+  for (auto const &bucket : _indirect.Buckets())
+  {
+    SetVertexFormat(bucket.format);
+    SetInstanceFormat(bucket.instanceFormat);
+    if (textured)
+      BindTexture(bucket.texture);
+    _indirect.Draw(bucket, _instances);
+  }
+  _indirect.Clear();
+  if (textured)
+    BindTexture(_activeTexture);
 }
 void Renderer::EnableStoredRender(bool value)
 {
+  // Queued rects and lines belong to the pass they were drawn in
+  BreakQueue();
+  _sprites.Clear();
+  if (!storedRender)
+    FlushLines();
+  _lines.Clear();
   storedRender = value;
   if (custom == false)
   {
@@ -670,6 +1025,7 @@ void Renderer::EnableStoredRender(bool value)
 
 void Renderer::SetLight(glm::vec4 pos, glm::vec3 color)
 {
+  BreakQueue();
   if (enableLighting)
   {
     if (QueryAndSet("default") || QueryAndSet("primary"))
@@ -700,38 +1056,35 @@ void Renderer::EnableShadows(bool b)
 }
 void Renderer::SetMaterial(glm::vec3 diff, glm::vec3 spec, float specExp)
 {
+  // Immediate draws keep the id as well, so the render queue can sort by it
+  int id = _materials.Intern(diff, spec, specExp);
   if (storedRender)
   {
-    auto l = std::find_if(_materials.begin(), _materials.end(), [&diff, &spec, specExp](MaterialInfo const &material) -> bool
-                          { return material.diff == diff && material.spec == spec && material.specExp == specExp; });
-    if (l == _materials.end())
-    {
-      _currentObject.materialID = _materials.size();
-      _materials.push_back({.diff = diff, .spec = spec, .specExp = specExp});
-    }
-    else
-    {
-      _currentObject.materialID = l - _materials.begin();
-    }
+    SubmissionContext::Local().material = id;
     return;
   }
+  _currentObject.materialID = id;
+  WriteMaterial(_currentObject.materialID);
+}
 
-  if (enableLighting)
+void Renderer::WriteMaterial(int id)
+{
+  if (!enableLighting || id < 0 || static_cast<size_t>(id) >= _materials.size())
+    return;
+  MaterialInfo material = _materials[id];
+  if (QueryAndSet("default") || QueryAndSet("primary"))
   {
-    if (QueryAndSet("default") || QueryAndSet("primary"))
+    if (_activePass->QuerryAttribute("diffuse_coefficient") == true)
     {
-      if (_activePass->QuerryAttribute("diffuse_coefficient") == true)
-      {
-        _activePass->WriteAttribute("diffuse_coefficient", &diff);
-      }
-      if (_activePass->QuerryAttribute("specular_coefficient") == true)
-      {
-        _activePass->WriteAttribute("specular_coefficient", &spec);
-      }
-      if (_activePass->QuerryAttribute("specular_exponent") == true)
-      {
-        _activePass->WriteAttribute("specular_exponent", &specExp);
-      }
+      _activePass->WriteAttribute("diffuse_coefficient", &material.diff);
+    }
+    if (_activePass->QuerryAttribute("specular_coefficient") == true)
+    {
+      _activePass->WriteAttribute("specular_coefficient", &material.spec);
+    }
+    if (_activePass->QuerryAttribute("specular_exponent") == true)
+    {
+      _activePass->WriteAttribute("specular_exponent", &material.specExp);
     }
   }
 }
@@ -740,7 +1093,10 @@ void Renderer::SetMaterial(int id)
 {
   if (id < 0 || id >= _materials.size())
     return;
-  _currentObject.materialID = id;
+  if (storedRender)
+    SubmissionContext::Local().material = id;
+  else
+    _currentObject.materialID = id;
 }
 
 glm::vec2 Renderer::GetWindowSize(Window *w)
@@ -751,6 +1107,11 @@ glm::vec2 Renderer::GetWindowSize(Window *w)
 
 void Renderer::SetMatrix(glm::mat4 const &matrix)
 {
+  if (storedRender)
+  {
+    SubmissionContext::Local().matrix = matrix;
+    return;
+  }
   if (_activePass->QuerryAttribute("objectMatrix") == false)
   {
     std::cerr << "ORB ERROR: Drawabled render stage must contain 4x4 matrix bound to name: objectMatrix" << std::endl;
@@ -758,14 +1119,22 @@ void Renderer::SetMatrix(glm::mat4 const &matrix)
         "ORB ERROR : Drawabled render stage must contain 4x4 matrix bound to name: objectMatrix");
   };
   _activePass->WriteAttribute("objectMatrix", (void *)&matrix);
+  _currentObject.matrix = matrix;
 }
 
 void Renderer::Update()
 {
+  // Rects and lines drawn outside of the stage callbacks
+  BreakQueue();
+  if (!storedRender)
+    FlushLines();
   while (_activePass->CurrentStage() != renderStage::PostFrameSwap)
   {
     _activePass->Update();
     _activePass->RunStage();
+    BreakQueue();
+    if (!storedRender)
+      FlushLines();
   }
 
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -792,6 +1161,15 @@ void Renderer::Update()
   CheckError(__LINE__);
   _activePass->ResetRender();
 
+  // Rebuild what changed on disk now that nothing is being drawn
+  if (_watcher)
+    HotReload();
+
+  // Finish any meshes the loader threads are done with before the next frame is drawn
+  MeshLibrary::Instance()->Update();
+  // Give back arena space that freed meshes left behind
+  GeometryArena::Compact();
+
   // SDL_UpdateWindowSurface(_window);
   CheckError(__LINE__);
 
@@ -806,6 +1184,19 @@ void Renderer::SetProjectionMode(int i)
 }
 
 void Renderer::SetActiveTexture(ORB_Texture *t)
+{
+  _activeTexture = t;
+  BindTexture(t);
+}
+void Renderer::SetUV(glm::mat4 const &uv)
+{
+  // Only stages that read texMulti moved texture coordinates before rects were batched
+  if (_activePass->QuerryAttribute("texMulti") == false)
+    return;
+  _uvMatrix = uv;
+  _activePass->WriteAttribute("texMulti", (void *)&uv);
+}
+void Renderer::BindTexture(ORB_Texture *t)
 {
   if (_activePass->QuerryAttribute("textured") == false)
   {
@@ -914,6 +1305,9 @@ void Renderer::UpdateRenderConstants()
     _storedProjection = _projectionMatrix * camMat;
     break;
   }
+  // The zoom scales w along with everything else, so it does not change what is on screen
+  _screenFrustum = Frustum::FromMatrix(_projectionMatrix);
+  _storedFrustum = Frustum::FromMatrix(_storedProjection);
   _activePass->WriteAttribute("screenMatrix", &_storedProjection[0][0]);
   _activePass->WriteAttribute("zoom", &_zoom);
   if (_activePass->QuerryAttribute("texMulti"))
@@ -958,6 +1352,12 @@ void Renderer::SetFillMode(int i)
 }
 
 void Renderer::SetBlendMode(int z)
+{
+  _blendMode = z;
+  ApplyBlendMode(z);
+}
+
+void Renderer::ApplyBlendMode(int z)
 {
   glEnable(GL_BLEND);
   switch (z)
@@ -985,6 +1385,7 @@ void Renderer::SetBlendMode(int z)
 
 void Renderer::BindTextureToUnit(ORB_Texture *tex, int texture)
 {
+  BreakQueue();
   if (texture < 0 or texture > 31)
     throw std::runtime_error("Attempted to bind to non-existant texture Unit");
   glActiveTexture(GL_TEXTURE0 + texture);
@@ -993,6 +1394,7 @@ void Renderer::BindTextureToUnit(ORB_Texture *tex, int texture)
 
 void Renderer::BindTextureToUnit(uint tex, int unit)
 {
+  BreakQueue();
   if (unit < 0 or unit > 31)
     throw std::runtime_error("Attempted to bind to non-existant texture Unit");
   glActiveTexture(GL_TEXTURE0 + unit);
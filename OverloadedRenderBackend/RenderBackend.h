@@ -10,15 +10,26 @@
 #include <glm.hpp>
 #include <SDL.h>
 #include <array>
+#include <optional>
 #include "Camera.h"
+#include "Frustum.h"
+#include "Sprite Batch.h"
+#include "Line Batch.h"
+#include "Instance Ring.h"
+#include "Indirect Batch.h"
+#include "Render Queue.h"
+#include "Material Table.h"
+#include "Submission Context.h"
 #include "Fonts.h"
 #include "Mesh.h"
 
 class RenderPass;
+class FileWatcher;
 typedef int (*renderCallBack)();
 typedef unsigned int uint;
 typedef struct ORB_Texture Texture;
 typedef struct Vertex Vertex;
+struct vertexAttribute;
 enum class renderStage;
 extern unsigned int _activePolyMode;
 typedef struct Window
@@ -82,6 +93,17 @@ public:
   void DrawRect(glm::vec2 pos, glm::vec2 scale, float rot, uint depth = 1);
   void DrawMesh(ORB_Mesh const & v, uint depth);
   void DrawIndexed(ORB_Mesh const & v, int count);
+  void DrawLine(glm::vec3 const& start, glm::vec3 const& end, uint depth = 1);
+  void DrawPolyline(std::span<glm::vec3 const> points, uint depth = 1);
+  void SetLineThickness(float thickness);
+  void SetLineJoin(LineJoin join);
+  /**
+   * @brief Draw the lines that have been queued since the last flush.
+   *
+   * @details Lines go through their own stage, so unlike rects they do not need to be drawn before state changes.
+   * Immediate lines are drawn at the end of each render stage, stored lines after the stored rects.
+   */
+  void FlushLines();
 
   void SetColor(glm::vec4 const& color);
   void SetMatrix(glm::vec3 const& pos, glm::vec3 const& scale);
@@ -92,6 +114,7 @@ public:
   void EnableLighting(bool value);
   void EnableShadows(bool b);
   void EnableStoredRender(bool value);
+  void EnableHotReload(bool value);
   void SetLight(glm::vec4 pos, glm::vec3 color);
   void SetMaterial(glm::vec3, glm::vec3, float);
   void SetMaterial(int id);
@@ -102,6 +125,30 @@ public:
   void SetProjectionMode(int);
 
   void SetActiveTexture(ORB_Texture* t);
+  /**
+   * @brief Set the matrix texture coordinates are moved by, stages without texMulti ignore it.
+   */
+  void SetUV(glm::mat4 const& uv);
+  /**
+   * @brief Draw the stored rects DrawRect has queued, with the state each was queued with.
+   *
+   * @details Stored rects are drawn after the stored meshes, immediate rects go through the render queue.
+   */
+  void FlushSprites();
+  /**
+   * @brief Submit the immediate meshes and rects queued since the last flush, sorted by the state they need.
+   *
+   * @details The queue records the layer, blend mode, fill mode, texture, material, matrices and colors of
+   * every draw, so changing those does not flush it. Anything it can not record flushes it first, and so does
+   * the end of every render stage.
+   */
+  void FlushQueue();
+  /**
+   * @brief Draw the stored calls of every mesh and clear them.
+   *
+   * @details Meshes that share a VAO, draw mode, vertex format and texture are drawn with one indirect multi draw.
+   */
+  void DrawStored(std::vector<ORB_Mesh*> const& meshes);
   
   void BindBuffer(std::string buffer);
   void UnbindBuffer(std::string buffer);
@@ -113,6 +160,16 @@ public:
   void WriteRenderConstantsHere();
 
   void SetBindings(GLuint b, GLuint VAO);
+  std::vector<vertexAttribute> const& VertexLayout();
+  size_t VertexStride();
+  /**
+   * @brief Tell the active stage how the next mesh stores its verticies, stages without octNormals are left alone.
+   */
+  void SetVertexFormat(VertexFormat format);
+  /**
+   * @brief Tell the active stage how the stored calls it reads are laid out, stages without instanceFormat are left alone.
+   */
+  void SetInstanceFormat(InstanceFormat format);
 
   glm::vec2 ToWorldSpace(glm::vec2);
   glm::vec2 ToScreenSpace(glm::vec2);
@@ -146,16 +203,42 @@ public:
   float  _zoom = 1;
 
   bool Stored() const {return storedRender;}
-  struct MaterialInfo {
-    glm::vec3 diff;
-    float buffer;
-    glm::vec3 spec;
-    float specExp;
-  };
-  std::vector<MaterialInfo> _materials;
+  /**
+   * @brief Get the planes of the camera's view in world space, from the projection stored calls are drawn with.
+   */
+  Frustum const& StoredFrustum() const { return _storedFrustum; }
+  /**
+   * @brief Get the ring stored instance data is written through, it is bound to RenderBuffer's binding.
+   */
+  InstanceRing& Instances() { return _instances; }
+  // Materials set in either mode, uploaded to MaterialBuffer's binding by stored rendering
+  MaterialTable _materials;
 private:
 
   void UpdateRenderConstants();
+  // Bind a texture for drawing without making it the active one
+  void BindTexture(ORB_Texture* t);
+  // Anything the render queue can not record draws what is queued first
+  void BreakQueue();
+  // Queue an immediate draw with the current state, a null mesh is a rect
+  void QueueDraw(ORB_Mesh const* mesh, int lod, uint depth, glm::mat4 const& matrix, glm::mat4 const& projection);
+  // Draw and clear the queued rects, texture is what is bound to the stage and is updated to what is left bound
+  void DrawSprites(std::optional<ORB_Texture*>& texture);
+  void ApplyBlendMode(int z);
+  // Write a material from _materials to the lighting uniforms
+  void WriteMaterial(int id);
+
+  // Rebuild whatever the watcher saw change, only called between frames
+  void HotReload();
+  void WatchPass();
+  /**
+   * @brief Pick the level of detail to draw a mesh with at the current object matrix.
+   *
+   * @param v the mesh
+   * @param model the object matrix it is drawn with
+   * @param projection the matrix the vertex shader projects with
+   */
+  int SelectLod(ORB_Mesh const& v, glm::mat4 const& model, glm::mat4 const& projection) const;
 
   // Projection mode
   int _projection = 0;
@@ -166,6 +249,10 @@ private:
   // Stored Projection
   glm::mat4 _storedProjection = glm::identity < glm::mat4 >();
 
+  // What each projection can see, rebuilt with the projections
+  Frustum _screenFrustum = Frustum::FromMatrix(glm::identity<glm::mat4>());
+  Frustum _storedFrustum = Frustum::FromMatrix(glm::identity<glm::mat4>());
+
 
   // Camera
   Camera mainCamera;
@@ -173,6 +260,9 @@ private:
   // The active renderpass
   RenderPass* _activePass;
 
+  // Watches the pass, shader and mesh files, nullptr unless hot reload is on
+  FileWatcher* _watcher = nullptr;
+
   // The current active window
   Window* _window;
 
@@ -185,6 +275,8 @@ private:
   
   // Fill mode
   GLuint renderMode = GL_TRIANGLE_FAN;
+  // The blend mode set with SetBlendMode, blending is on from the start
+  int _blendMode = 1;
 
   bool enableLighting = false;
   bool storedRender = false;
@@ -193,5 +285,21 @@ private:
 
   RenderInformation _currentObject;
 
+  // What the next rect is drawn with
+  glm::vec4 _color = {1, 1, 1, 1};
+  glm::mat4 _uvMatrix = glm::identity<glm::mat4>();
+  ORB_Texture* _activeTexture = nullptr;
+  // Rects waiting to be drawn
+  SpriteBatch _sprites;
+  InstanceRing _instances;
+  // Stored calls grouped by the state they are drawn with
+  IndirectBatch _indirect;
+  // Immediate meshes and rects waiting to be sorted
+  RenderQueue _queue;
+  // Lines waiting to be drawn and what the next one is drawn with
+  LineBatch _lines;
+  float _lineThickness = 1;
+  LineJoin _lineJoin = LineJoin::Miter;
+
 
 };
@@ -12,7 +12,9 @@
 #include "RenderBackend.h"
 #include "ShaderStage.h"
 #include "Stream.h"
+#include "File Watcher.h"
 #include <algorithm>
+#include <unordered_set>
 #include <tuple>
 
 #define _countof(array) (sizeof(array) / sizeof(array[0]))
@@ -88,27 +90,12 @@ void RenderPass::FlattenFBOs()
   glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
   s->BindBuffer("VAO");
   s->BindBuffer("VBO");
-#ifndef __CLANG
-  if constexpr (std::endian::native == std::endian::little)
+  // The flatten stage lays out pos (location 0) then texPos (location 2), the same as Vertex above
+  if (!_flattenUploaded)
   {
-    s->WriteBuffer("VBO", _countof(mesh) * sizeof(Vertex), nullptr);
-    for (int i = 0; i < _countof(mesh); ++i)
-    {
-      Vertex const &v = mesh[i];
-      glBufferSubData(GL_ARRAY_BUFFER, (i * sizeof(Vertex)) + 0,
-                      sizeof(Vertex::tex), &(v.tex));
-      glBufferSubData(GL_ARRAY_BUFFER,
-                      (i * sizeof(Vertex)) + 0 + sizeof(Vertex::tex),
-                      sizeof(Vertex::pos), &(v.pos));
-    }
-  }
-  else if constexpr (std::endian::native == std::endian::big)
-  {
-#endif
     s->WriteBuffer("VBO", _countof(mesh) * sizeof(Vertex), (void *)mesh);
-#ifndef __CLANG
-}
-#endif
+    _flattenUploaded = true;
+  }
 
   // glBlendEquation(GL_MAX);
   glActiveTexture(GL_TEXTURE1);
@@ -387,6 +374,16 @@ void RenderPass::SetBindings(GLuint b, GLuint VAO)
   std::get<2>(_activeShaderStage)->SetBindings(b, VAO);
 }
 
+std::vector<vertexAttribute> const &RenderPass::VertexLayout()
+{
+  return std::get<2>(_activeShaderStage)->Layout();
+}
+
+size_t RenderPass::VertexStride()
+{
+  return std::get<2>(_activeShaderStage)->Stride();
+}
+
 void RenderPass::SetupDefaultFBOs()
 {
   GLuint defaultFBOs[6] = {0};
@@ -465,8 +462,6 @@ RenderPass::RenderPass(const int v)
     GLuint newBuffer = 0;
     glGenBuffers(1, &newBuffer);
     _buffers["RenderBuffer"] = {newBuffer, GL_SHADER_STORAGE_BUFFER};
-    glGenBuffers(1, &newBuffer);
-    _buffers["MaterialBuffer"] = {newBuffer, GL_SHADER_STORAGE_BUFFER};
 
     GLuint fbo;
     GLuint depth;
@@ -491,16 +486,23 @@ RenderPass::RenderPass(const int v)
 
 RenderPass::RenderPass(const char *f) : RenderPass(std::string(f)) {}
 
-RenderPass::RenderPass(std::string path) : _flattenStage(new ShaderStage(1))
+RenderPass::RenderPass(std::string path) : _flattenStage(new ShaderStage(1)), _path(path)
 {
+  Load(path);
+}
 
+void RenderPass::Load(std::string const &path)
+{
   Stream file(path);
   if (file.Open() == false)
     throw std::invalid_argument("Bad file path");
+  // Everything the file names, whatever a previous load made that is not in here gets dropped
+  std::unordered_set<std::string> stages, fbos, buffers;
   // Read each line and check for <
   std::string token;
   auto screenSize = glm::vec2(1280, 720); /* GLBackend::GetWindowDimensions();*/
-  SetupDefaultFBOs();
+  if (std::get<1>(_primaryFBOs[0]) == 0)
+    SetupDefaultFBOs();
   while (file.isEOF() != true)
   {
     // if we fine a < then set what section we are reading
@@ -526,9 +528,27 @@ RenderPass::RenderPass(std::string path) : _flattenStage(new ShaderStage(1))
             const size_t eq = token.find('=');
             token = token.erase(0, eq + 1);
             unsigned int id = std::stoi(token);
+            std::string key = name.substr(name.rfind('/') + 1);
+            stages.insert(key);
+            auto existing = _passess.find(key);
+            if (existing != _passess.end() && std::get<2>(existing->second)->Path() == name + ".meta")
+            {
+              // Same shader, only where it runs can have changed
+              std::get<0>(existing->second) = stage;
+              std::get<1>(existing->second) = id;
+              continue;
+            }
             ShaderStage *s = new ShaderStage(name + ".meta");
             s->parent = this;
-            _passess[name.substr(name.rfind('/') + 1)] = {stage, id, s};
+            if (existing != _passess.end())
+            {
+              ShaderStage *old = std::get<2>(existing->second);
+              existing->second = {stage, id, s};
+              SwapStage(old, s);
+              delete old;
+            }
+            else
+              _passess[key] = {stage, id, s};
           }
         }
       }
@@ -548,11 +568,18 @@ RenderPass::RenderPass(std::string path) : _flattenStage(new ShaderStage(1))
             // erase up to and afterthe equal sign
             token = token.erase(0, eq + 1);
             renderStage stage = static_cast<renderStage>(std::stoi(token));
+            fbos.insert(name);
+            if (_additionalFBOs.contains(name))
+            {
+              std::get<0>(_additionalFBOs[name]) = stage;
+              continue;
+            }
             GLuint newFBO;
             GLuint newTexture;
             GLuint depth;
             glGenFramebuffers(1, &newFBO);
             glGenTextures(1, &newTexture);
+            glGenTextures(1, &depth);
             glBindFramebuffer(GL_FRAMEBUFFER, newFBO);
             glBindTexture(GL_TEXTURE_2D, newTexture);
             glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA32F,
@@ -591,6 +618,14 @@ RenderPass::RenderPass(std::string path) : _flattenStage(new ShaderStage(1))
           // Erase the name
           token.erase(token.begin(), token.begin() + bracket + 1);
           int type = std::stoi(token);
+          buffers.insert(name);
+          auto existing = _buffers.find(name);
+          if (existing != _buffers.end())
+          {
+            if (existing->second.second == bufferTypes.at(type))
+              continue;
+            glDeleteBuffers(1, &existing->second.first);
+          }
           GLuint newBuffer = 0;
           glGenBuffers(1, &newBuffer);
           _buffers[name] = {newBuffer, bufferTypes.at(type)};
@@ -599,6 +634,113 @@ RenderPass::RenderPass(std::string path) : _flattenStage(new ShaderStage(1))
       }
     }
   }
+
+  for (auto it = _passess.begin(); it != _passess.end();)
+  {
+    if (stages.contains(it->first))
+    {
+      ++it;
+      continue;
+    }
+    ShaderStage *old = std::get<2>(it->second);
+    it = _passess.erase(it);
+    SwapStage(old, nullptr);
+    delete old;
+  }
+  for (auto it = _additionalFBOs.begin(); it != _additionalFBOs.end();)
+  {
+    if (fbos.contains(it->first))
+    {
+      ++it;
+      continue;
+    }
+    glDeleteFramebuffers(1, &std::get<1>(it->second));
+    glDeleteTextures(1, &std::get<2>(it->second));
+    glDeleteTextures(1, &std::get<3>(it->second));
+    it = _additionalFBOs.erase(it);
+  }
+  for (auto it = _buffers.begin(); it != _buffers.end();)
+  {
+    if (buffers.contains(it->first))
+    {
+      ++it;
+      continue;
+    }
+    glDeleteBuffers(1, &it->second.first);
+    it = _buffers.erase(it);
+  }
+}
+
+void RenderPass::Reload()
+{
+  try
+  {
+    Load(_path);
+  }
+  catch (std::exception const &e)
+  {
+    // Whatever loaded before the error is kept, the pass stays usable
+    Log(Error, "Failed to reload render pass", _path + ":", e.what());
+  }
+}
+
+bool RenderPass::ReloadStage(std::string const &file)
+{
+  std::string changed = FileWatcher::Normalize(file);
+  bool found = false;
+  for (auto &pass : _passess)
+  {
+    ShaderStage *old = std::get<2>(pass.second);
+    if (old->Path().empty())
+      continue;
+    bool uses = FileWatcher::Normalize(old->Path()) == changed;
+    for (auto &source : old->Sources())
+      uses = uses || FileWatcher::Normalize(source) == changed;
+    if (!uses)
+      continue;
+    found = true;
+    try
+    {
+      ShaderStage *s = new ShaderStage(old->Path());
+      s->parent = this;
+      std::get<2>(pass.second) = s;
+      SwapStage(old, s);
+      delete old;
+      Log(Message, "Reloaded shader stage", pass.first);
+    }
+    catch (std::exception const &e)
+    {
+      // A shader that does not compile keeps the old program running
+      Log(Error, "Failed to reload shader stage", pass.first + ":", e.what());
+    }
+  }
+  return found;
+}
+
+std::vector<std::string> RenderPass::Files() const
+{
+  std::vector<std::string> files;
+  if (!_path.empty())
+    files.push_back(_path);
+  for (auto &pass : _passess)
+  {
+    ShaderStage *s = std::get<2>(pass.second);
+    if (s->Path().empty())
+      continue;
+    files.push_back(s->Path());
+    files.insert(files.end(), s->Sources().begin(), s->Sources().end());
+  }
+  return files;
+}
+
+void RenderPass::SwapStage(ShaderStage *old, ShaderStage *replacement)
+{
+  if (std::get<2>(_activeShaderStage) != old)
+    return;
+  if (replacement != nullptr)
+    std::get<2>(_activeShaderStage) = replacement;
+  else
+    _activeShaderStage = _passess.empty() ? ShaderPass() : _passess.begin()->second;
 }
 
 RenderPass::RenderPass(RenderPass const &r) {}
@@ -609,8 +751,19 @@ RenderPass &RenderPass::operator=(RenderPass const &)
   return *this;
 }
 
+ShaderStage *RenderPass::LineStage()
+{
+  if (_lineStage == nullptr)
+  {
+    _lineStage = new ShaderStage(4);
+    _lineStage->parent = this;
+  }
+  return _lineStage;
+}
+
 RenderPass::~RenderPass()
 {
+  delete _lineStage;
   for (auto &pass : _passess)
   {
     delete std::get<2>(pass.second);
@@ -11,7 +11,10 @@
 #include <unordered_map>
 #include <map>
 #include <array>
+#include <string>
+#include <vector>
 class ShaderStage;
+struct vertexAttribute;
 // RenderPass
 // ----------------------------------
 // ----------------------------------
@@ -128,6 +131,10 @@ public:
    *
    */
   void FlattenFBOs();
+  /**
+   * @brief The built in stage lines are drawn with, made the first time it is asked for.
+   */
+  ShaderStage *LineStage();
 
   /**
    * @brief Register a callBack function for a specific renderstage.
@@ -201,7 +208,41 @@ public:
 
   void SetBindings(GLuint b, GLuint VAO);
 
+  /**
+   * @brief Get the vertex layout of the active stage.
+   *
+   * @return the inputs in location order, see ShaderStage::Layout
+   */
+  std::vector<vertexAttribute> const &VertexLayout();
+  /**
+   * @brief Get the size of one vertex of the active stage in bytes.
+   */
+  size_t VertexStride();
+
+  /**
+   * @brief Read the pass file again, only stages, FBOs and buffers that changed are rebuilt.
+   *
+   */
+  void Reload();
+  /**
+   * @brief Rebuild the shader stages loaded from a file.
+   *
+   * @param file a stage's .meta file or one of its GLSL sources
+   * @return whether any stage uses the file
+   */
+  bool ReloadStage(std::string const &file);
+  /**
+   * @brief Get every file this pass was built from.
+   *
+   * @return the pass file, the stage .meta files and their GLSL sources
+   */
+  std::vector<std::string> Files() const;
+  std::string const &Path() const { return _path; }
+
 private:
+  void Load(std::string const &path);
+  // Point the active stage at a stage that replaced it, nullptr if it was removed
+  void SwapStage(ShaderStage *old, ShaderStage *replacement);
 
   void SetupDefaultFBOs();
   bool CheckBufferExists(std::string &s);
@@ -218,4 +259,9 @@ private:
   ShaderPass _activeShaderStage;
   renderStage _activeStage = renderStage::PreRender;
   ShaderStage *_flattenStage = nullptr;
+  // The flatten quad never changes, so it is only uploaded the first time
+  bool _flattenUploaded = false;
+  ShaderStage *_lineStage = nullptr;
+  // The file this pass was loaded from, empty for the built in passes
+  std::string _path;
 };
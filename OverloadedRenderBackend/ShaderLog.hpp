@@ -6,6 +6,7 @@
  * @author Lorenzo St. Luce(lorenzo.stluce)
  * @date   November 2023
  *********************************************************************/
+#pragma once
 #include <iostream>
 #include <fstream>
 #include <stacktrace>
@@ -16,6 +16,7 @@ constexpr int ENABLE_SHADER_PRINTF = 0;
 #include "../ShaderPrintf/shaderprintf.h"
 #endif
 #include "Stream.h"
+#include "Indirect Batch.h"
 
 #include "ShaderLog.hpp"
 void CheckError(int i);
@@ -71,6 +72,7 @@ GLuint createShader(const std::string &path, GLenum shaderType)
 GLuint ShaderStage::CreateShader(GLenum type, const char *filepath)
 {
   auto &frag = loadFile(filepath);
+  _sources.push_back(filepath);
   GLuint result = glCreateShader(type);
   auto p = frag.data();
   glShaderSource(result, 1, &p, nullptr);
@@ -101,11 +103,19 @@ void ShaderStage::InitializeShaderProgram()
 
   // Read that section
   // Loop the input attributes
-  size_t totalSize = 0;
+  _layout.clear();
   for (auto &in : _inputAttributes)
   {
-    glBindAttribLocation(_program, in.second.first, in.first.c_str());
-    totalSize += in.second.second;
+    glBindAttribLocation(_program, in.second.location, in.first.c_str());
+    _layout.push_back(in.second);
+  }
+  std::sort(_layout.begin(), _layout.end(), [](vertexAttribute const &a, vertexAttribute const &b)
+            { return a.location < b.location; });
+  _stride = 0;
+  for (auto &in : _layout)
+  {
+    in.offset = _stride;
+    _stride += AttributeBytes(in);
   }
   glLinkProgram(_program);
 
@@ -133,28 +143,7 @@ void ShaderStage::InitializeShaderProgram()
 
     glBindVertexArray(_buffers["VAO"].first);
     glBindBuffer(GL_ARRAY_BUFFER, _buffers["VBO"].first);
-    for (auto &in : _inputAttributes)
-    {
-      glEnableVertexAttribArray(in.second.first);
-      if (glEnableVertexArrayAttrib)
-      {
-        glEnableVertexArrayAttrib(_buffers["VAO"].first, in.second.first);
-      }
-    }
-    size_t offset = 0;
-
-    for (auto &in : _inputAttributes)
-    {
-      glVertexAttribPointer(
-          in.second.first,
-          static_cast<GLint>(in.second.second),
-          GL_FLOAT,
-          GL_FALSE,
-          static_cast<GLsizei>(totalSize) * sizeof(float),
-          reinterpret_cast<void *>(offset * sizeof(float)));
-      offset += in.second.second;
-      CheckError(__LINE__);
-    }
+    BindLayout();
     glBindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
   }
@@ -217,39 +206,12 @@ GLuint ShaderStage::QueryBufferID(std::string buffer)
 std::string ShaderStage::MakeExtraVAO(std::string name)
 {
   GLuint temp;
-  size_t totalSize = 0;
-  for (auto &in : _inputAttributes)
-  {
-    totalSize += in.second.second;
-  }
   glGenVertexArrays(1, &temp);
   _buffers[name] = {temp, GL_ARRAY_BUFFER_BINDING};
 
   glBindVertexArray(_buffers[name].first);
   glBindBuffer(GL_ARRAY_BUFFER, _buffers["VBO"].first);
-  for (auto &in : _inputAttributes)
-  {
-    glEnableVertexAttribArray(in.second.first);
-    if (glEnableVertexArrayAttrib)
-    {
-      glEnableVertexArrayAttrib(_buffers["VAO"].first, in.second.first);
-    }
-  }
-  CheckError(__LINE__);
-  size_t offset = 0;
-
-  for (auto &in : _inputAttributes)
-  {
-    glVertexAttribPointer(
-        in.second.first,
-        static_cast<GLint>(in.second.second),
-        GL_FLOAT,
-        GL_FALSE,
-        static_cast<GLsizei>(totalSize) * sizeof(float),
-        reinterpret_cast<void *>(offset * sizeof(float)));
-    offset += in.second.second;
-    CheckError(__LINE__);
-  }
+  BindLayout();
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindVertexArray(0);
   CheckError(__LINE__);
@@ -266,41 +228,19 @@ bool ShaderStage::HasBuffer(std::string name)
   return _buffers.contains(name);
 }
 
+void ShaderStage::BindLayout()
+{
+  BindVertexLayout(_layout, _stride);
+  CheckError(__LINE__);
+}
+
 void ShaderStage::SetBindings(GLuint b, GLuint VA)
 {
-  size_t totalSize = 0;
-  for (auto &in : _inputAttributes)
-  {
-    totalSize += in.second.second;
-  }
   CheckError(__LINE__);
   glBindVertexArray(VA);
   glBindBuffer(GL_ARRAY_BUFFER, b);
   CheckError(__LINE__);
-  for (auto &in : _inputAttributes)
-  {
-    glEnableVertexAttribArray(in.second.first);
-    if (glEnableVertexArrayAttrib)
-    {
-      glEnableVertexArrayAttrib(_buffers["VAO"].first, in.second.first);
-    }
-    CheckError(__LINE__);
-  }
-  CheckError(__LINE__);
-  size_t offset = 0;
-
-  for (auto &in : _inputAttributes)
-  {
-    glVertexAttribPointer(
-        in.second.first,
-        static_cast<GLint>(in.second.second),
-        GL_FLOAT,
-        GL_FALSE,
-        static_cast<GLsizei>(totalSize) * sizeof(float),
-        reinterpret_cast<void *>(offset * sizeof(float)));
-    offset += in.second.second;
-    CheckError(__LINE__);
-  }
+  BindLayout();
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindVertexArray(0);
   CheckError(__LINE__);
@@ -320,6 +260,7 @@ ShaderStage::ShaderStage(int version)
     FLATTEN,
     DEFAULT_STORED_RENDER,
     DEFAULT_SHADOW_PASS,
+    LINES,
   };
   _program = glCreateProgram();
   Log(Message, "Standard Shader Ctor");
@@ -377,6 +318,7 @@ ShaderStage::ShaderStage(int version)
     _uniformAttributes["globalColor"] = {0, 16};
     _uniformAttributes["light_position"] = {0, 16};
     _uniformAttributes["eye_position"] = {0, 16};
+    _uniformAttributes["octNormals"] = {0, 1};
 
     // TODO: make ORB Settings function to enable or disable lighting, make functions to set light positions and material properties
     // Then turn the lighting into a multipass shader that uses a shadow mask to create shadows
@@ -478,6 +420,8 @@ ShaderStage::ShaderStage(int version)
     _uniformAttributes["light_color"] = {0, 12};
     _uniformAttributes["light_position"] = {0, 16};
     _uniformAttributes["eye_position"] = {0, 16};
+    _uniformAttributes["octNormals"] = {0, 1};
+    _uniformAttributes["instanceFormat"] = {0, 1};
 
     // Then turn the lighting into a multipass shader that uses a shadow mask to create shadows
 
@@ -510,13 +454,54 @@ ShaderStage::ShaderStage(int version)
     _inputAttributes["texcoord"] = {3, 2};
     _uniformAttributes["screenMatrix"] = {0, 64};
     _uniformAttributes["zoom"] = {0, 4};
+    _uniformAttributes["instanceFormat"] = {0, 1};
+  }
+  break;
+  case VERSIONS::LINES:
+  {
+#include "lines.vert.inc"
+#include "lines.frag.inc"
+    const char *const vert = lines_vert;
+    const char *const frag = lines_frag;
+    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER), vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(fragmentShader, 1, &frag, nullptr);
+    glShaderSource(vertexShader, 1, &vert, nullptr);
+    glCompileShader(vertexShader);
+    int linkok = 0;
+    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &linkok);
+    if (linkok == 0)
+    {
+      char buffer[1000];
+      GLsizei len;
+      glGetShaderInfoLog(vertexShader, _countof(buffer), &len, buffer);
+      Log(Error, "Compile Failed: ", buffer);
+      throw std::runtime_error(buffer);
+    }
+    glCompileShader(fragmentShader);
+    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &linkok);
+    if (linkok == 0)
+    {
+      char buffer[1000];
+      GLsizei len;
+      glGetShaderInfoLog(fragmentShader, _countof(buffer), &len, buffer);
+      Log(Error, "Compile Failed: ", buffer);
+      throw std::runtime_error(buffer);
+    }
+    glAttachShader(_program, fragmentShader);
+    glAttachShader(_program, vertexShader);
+    // No vertex inputs, the points are read from the LinePoints buffer
+    _uniformAttributes["screenMatrix"] = {0, 64};
+    _uniformAttributes["zoom"] = {0, 4};
+    _uniformAttributes["viewport"] = {0, 8};
+
+    _activeShaders |= static_cast<int>(shaderStages::fragment) | static_cast<int>(shaderStages::vertex);
   }
   break;
   }
   InitializeShaderProgram();
 }
 
-ShaderStage::ShaderStage(std::string path)
+ShaderStage::ShaderStage(std::string path) : _path(path)
 {
   Stream file(path);
   if (file.Open() == false)
@@ -603,13 +588,27 @@ ShaderStage::ShaderStage(std::string path)
           // Erase the name and the equal sign
           token.erase(token.begin(), token.begin() + bracket + 1);
           size_t size = std::stoi(token);
+          vertexAttribute attribute = {0, size};
+          // An optional type follows the size, name[size,type]=location
+          size_t comma = token.find(',');
           size_t equalSign = token.find('=');
+          if (comma != std::string::npos && comma < equalSign)
+          {
+            std::string type = makeLowerCase(token.substr(comma + 1, token.find(']') - comma - 1));
+            if (!ParseAttributeType(type, attribute))
+              Log(Error, "Unknown attribute type:", type, "for:", name, "in Shader:", path);
+            attribute.size = attribute.oct ? 2 : size;
+          }
           token.erase(token.begin(), token.begin() + equalSign + 1);
           // Get the position
-          GLuint pos = std::stoi(token);
+          attribute.location = std::stoi(token);
+          // The shared mesh VAOs feed the base instance of stored draws there
+          if (attribute.location == InstanceBaseAttribute)
+            Log(Warning, "Attribute:", name, "in Shader:", path, "uses location", InstanceBaseAttribute,
+                "which is reserved for the base instance of stored draws");
           // Save it
-          _inputAttributes[name] = {pos, size};
-          Log(Message, "Added Attribute:", name, "at location:", pos, "to Shader:", path);
+          _inputAttributes[name] = attribute;
+          Log(Message, "Added Attribute:", name, "at location:", attribute.location, "to Shader:", path);
         }
       }
       else if (token == "<uniform>")
@@ -678,7 +677,7 @@ ShaderStage::ShaderStage(const char *path) : ShaderStage(std::string(path))
 
 ShaderStage::ShaderStage(ShaderStage &s)
     : _uniformAttributes(s._uniformAttributes), _inputAttributes(s._inputAttributes),
-      _buffers(s._buffers), _activeShaders(s._activeShaders), _program(s._program)
+      _buffers(s._buffers), _layout(s._layout), _stride(s._stride), _path(s._path), _sources(s._sources), _activeShaders(s._activeShaders), _program(s._program)
 {
   s.keepAlive = true;
 }
@@ -688,6 +687,10 @@ ShaderStage &ShaderStage::operator=(ShaderStage const &s)
   _uniformAttributes = s._uniformAttributes;
   _inputAttributes = s._inputAttributes;
   _buffers = s._buffers;
+  _layout = s._layout;
+  _stride = s._stride;
+  _path = s._path;
+  _sources = s._sources;
   _activeShaders = s._activeShaders;
   _program = s._program;
   const_cast<ShaderStage &>(s).keepAlive = true;
@@ -10,6 +10,9 @@
 
 #include <glad.h>
 #include <unordered_map>
+#include <string>
+#include <vector>
+#include "Vertex.h"
 
 // Read in the meta file
 // load the shaders and create the program
@@ -156,8 +159,29 @@ public:
     bool HasVAO(std::string name);
     bool HasBuffer(std::string name);
 
+    /**
+     * @brief Get the .meta file this stage was loaded from, empty for the built in stages.
+     */
+    std::string const& Path() const { return _path; }
+    /**
+     * @brief Get the GLSL files this stage was compiled from.
+     */
+    std::vector<std::string> const& Sources() const { return _sources; }
+
     void SetBindings(GLuint b, GLuint VA);
 
+    /**
+     * @brief Get the interleaved layout vertex buffers need for this stage.
+     *
+     * @details Inputs are packed in location order with no padding
+     * @return the inputs, sorted by location
+     */
+    std::vector<vertexAttribute> const& Layout() const { return _layout; }
+    /**
+     * @brief Get the size of one vertex in bytes.
+     */
+    size_t Stride() const { return _stride; }
+
 private:
     /**
      * @brief Create a shader from a file
@@ -175,11 +199,21 @@ private:
     bool hasStage(shaderStages s);
 
     void InitializeShaderProgram();
+    /**
+     * @brief Set the attribute pointers of the bound VAO to the stage's layout, reading from the bound buffer.
+     */
+    void BindLayout();
 
     // Using unordered map cause we dont care about order
     std::unordered_map<std::string, shaderAttribute> _uniformAttributes;
-    std::unordered_map<std::string, shaderAttribute> _inputAttributes;
+    std::unordered_map<std::string, vertexAttribute> _inputAttributes;
     std::unordered_map<std::string, shaderBuffer> _buffers;
+    // _inputAttributes sorted by location, so the layout does not depend on the map's order
+    std::vector<vertexAttribute> _layout;
+    size_t _stride = 0;
+
+    std::string _path;
+    std::vector<std::string> _sources;
 
     long _activeShaders = 0;
     bool keepAlive = false;
@@ -0,0 +1,93 @@
+#include "pch.h"
+#include "Sprite Batch.h"
+
+SpriteBatch::~SpriteBatch()
+{
+  if (_vao == 0)
+    return;
+  glDeleteBuffers(1, &_vertexBuffer);
+  glDeleteBuffers(1, &_indexBuffer);
+  glDeleteVertexArrays(1, &_vao);
+}
+
+void SpriteBatch::Add(ORB_Texture* texture, unsigned int depth, glm::mat4 const& matrix, glm::vec4 const& color, glm::mat4 const& uv)
+{
+  if (_runs.empty() || _runs.back().texture != texture || _runs.back().depth != depth)
+    _runs.push_back({texture, depth, _verticies.size() / 4, 0});
+  ++_runs.back().count;
+
+  // The corners of the unit rect are the center plus or minus half of each axis
+  glm::vec4 center = matrix[3];
+  glm::vec4 x = matrix[0] * 0.5f;
+  glm::vec4 y = matrix[1] * 0.5f;
+  // Flipped rects face the other way, rects scaled to nothing keep facing the camera
+  glm::vec3 facing = glm::cross(glm::vec3(x), glm::vec3(y));
+  float length = glm::length(facing);
+  glm::vec4 normal = length > 0 ? glm::vec4(facing / length, 0) : glm::vec4(0, 0, 1, 0);
+  auto corner = [&](glm::vec4 pos, float u, float v) -> Vertex
+  {
+    glm::vec2 tex = glm::vec2(uv[3]) + glm::vec2(uv[0]) * u + glm::vec2(uv[1]) * v;
+    return {pos, color, normal, tex};
+  };
+  _verticies.push_back(corner(center - x - y, 0, 1));
+  _verticies.push_back(corner(center + x - y, 1, 1));
+  _verticies.push_back(corner(center + x + y, 1, 0));
+  _verticies.push_back(corner(center - x + y, 0, 0));
+}
+
+void SpriteBatch::Upload(std::vector<vertexAttribute> const& layout, size_t stride)
+{
+  if (_vao == 0)
+    CreateBuffers();
+  std::span<const Vertex> verticies = _verticies;
+  if (IsVertexLayout(layout, stride))
+    glNamedBufferData(_vertexBuffer, verticies.size_bytes(), verticies.data(), GL_STREAM_DRAW);
+  else
+  {
+    PackVerticies(verticies, layout, stride, _packed);
+    glNamedBufferData(_vertexBuffer, _packed.size(), _packed.data(), GL_STREAM_DRAW);
+  }
+  // Custom passes can change the layout between frames, so it is set every upload
+  glBindVertexArray(_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
+  BindVertexLayout(layout, stride);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+}
+
+void SpriteBatch::Draw(spriteRun const& run) const
+{
+  glBindVertexArray(_vao);
+  // Every rect uses the same 6 indicies, the base vertex moves them to the right rect
+  for (size_t first = 0; first < run.count; first += MaxBatchSprites)
+  {
+    size_t count = std::min(run.count - first, MaxBatchSprites);
+    glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(count * 6), GL_UNSIGNED_SHORT, nullptr,
+                             static_cast<GLint>((run.first + first) * 4));
+  }
+  glBindVertexArray(0);
+}
+
+void SpriteBatch::Clear()
+{
+  _verticies.clear();
+  _runs.clear();
+}
+
+void SpriteBatch::CreateBuffers()
+{
+  std::vector<uint16_t> indicies(MaxBatchSprites * 6);
+  for (size_t i = 0; i < MaxBatchSprites; ++i)
+  {
+    uint16_t v = static_cast<uint16_t>(i * 4);
+    uint16_t quad[6] = {v, static_cast<uint16_t>(v + 1), static_cast<uint16_t>(v + 2), v, static_cast<uint16_t>(v + 2), static_cast<uint16_t>(v + 3)};
+    std::copy(std::begin(quad), std::end(quad), indicies.begin() + i * 6);
+  }
+  glCreateBuffers(1, &_vertexBuffer);
+  glCreateBuffers(1, &_indexBuffer);
+  glNamedBufferStorage(_indexBuffer, indicies.size() * sizeof(uint16_t), indicies.data(), 0);
+  glGenVertexArrays(1, &_vao);
+  glBindVertexArray(_vao);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer);
+  glBindVertexArray(0);
+}
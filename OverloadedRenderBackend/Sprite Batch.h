@@ -0,0 +1,80 @@
+#pragma once
+#include <vector>
+#include "Vertex.h"
+
+struct ORB_Texture;
+
+// The most rects drawn by one call, keeps the indicies 16 bit
+constexpr size_t MaxBatchSprites = 1 << 14;
+
+/**
+ * @brief Rects in a row that are drawn with the same texture to the same layer.
+ *
+ * texture - the texture bound while drawing, nullptr for none
+ * depth - the layer DrawRect was given
+ * first - the first rect of the run
+ * count - how many rects there are
+ */
+typedef struct spriteRun
+{
+  ORB_Texture* texture;
+  unsigned int depth;
+  size_t first;
+  size_t count;
+}spriteRun;
+
+/**
+ * @brief Collects rects so many of them can be drawn with one upload and a draw per run.
+ *
+ * @details Each rect is turned into 4 verticies on the CPU with its transform, color and UVs already applied,
+ * so the stage needs no per rect uniforms. The verticies go into a buffer that is orphaned every upload.
+ */
+class SpriteBatch
+{
+public:
+  SpriteBatch() = default;
+  ~SpriteBatch();
+  SpriteBatch(SpriteBatch const&) = delete;
+  SpriteBatch& operator=(SpriteBatch const&) = delete;
+
+  /**
+   * @brief Queue a unit rect centered on the origin.
+   *
+   * @param texture the texture to draw it with
+   * @param depth the layer to draw it to
+   * @param matrix moves the rect into place
+   * @param color multiplies the vertex color
+   * @param uv moves the texture coordinates
+   */
+  void Add(ORB_Texture* texture, unsigned int depth, glm::mat4 const& matrix, glm::vec4 const& color, glm::mat4 const& uv);
+
+  bool Empty() const { return _runs.empty(); }
+  std::vector<spriteRun> const& Runs() const { return _runs; }
+
+  /**
+   * @brief Send every queued rect to the GPU, call once before drawing the runs.
+   *
+   * @param layout how the stage reads verticies
+   * @param stride the size of one vertex in bytes
+   */
+  void Upload(std::vector<vertexAttribute> const& layout, size_t stride);
+  /**
+   * @brief Draw one run, the state it needs must already be set.
+   */
+  void Draw(spriteRun const& run) const;
+  /**
+   * @brief Forget every queued rect.
+   */
+  void Clear();
+
+private:
+  void CreateBuffers();
+
+  std::vector<Vertex> _verticies;
+  std::vector<spriteRun> _runs;
+  // The verticies in the stage's layout, when it is not Vertex as is
+  std::vector<char> _packed;
+  GLuint _vao = 0;
+  GLuint _vertexBuffer = 0;
+  GLuint _indexBuffer = 0;
+};
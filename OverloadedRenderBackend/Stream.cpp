@@ -10,6 +10,7 @@
 
 #include "Stream.h"
 #include <algorithm>
+#include <charconv>
 std::string makeLowerCase(std::string s)
 {
   std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
@@ -25,14 +26,23 @@ fileTypes GetFileType(std::string s)
     return fileTypes::xml;
   if (s == ".obj")
     return fileTypes::obj;
+  if (s == ".orbm")
+    return fileTypes::binary;
   return fileTypes::invalid;
 }
 
 
-Stream::Stream(const char* fileName)
+Stream::Stream(const char* fileName) : _path(fileName)
 {
-    _s.open(fileName);
-    _path = fileName;
+  try
+  {
+    _file = MappedFile(_path);
+    _buffer = _file.View();
+  }
+  catch (std::runtime_error const&)
+  {
+    // Open() reports it, the same as a stream that failed to open
+  }
 }
 
 Stream::Stream(std::string const& fileName) : Stream(fileName.c_str())
@@ -41,85 +51,142 @@ Stream::Stream(std::string const& fileName) : Stream(fileName.c_str())
 
 Stream::~Stream()
 {
-    if (_s.is_open())
-        _s.close();
 }
 
 size_t Stream::location()
 {
-    return _s.tellg();
+    return _pos;
+}
+
+void Stream::skipSpace()
+{
+  while (_pos < _buffer.size() && IsSpace(_buffer[_pos]))
+    ++_pos;
+  if (_pos >= _buffer.size())
+    _eof = true;
+}
+
+template<typename t>
+t Stream::readNumber()
+{
+  skipSpace();
+  t value = t();
+  const char* begin = _buffer.data() + _pos;
+  const char* end = _buffer.data() + _buffer.size();
+  // from_chars does not take a leading +
+  if (begin != end && *begin == '+')
+    ++begin;
+  auto res = std::from_chars(begin, end, value);
+  if (res.ec != std::errc())
+    return t();
+  _pos = res.ptr - _buffer.data();
+  if (_pos >= _buffer.size())
+    _eof = true;
+  return value;
 }
 
 int Stream::readInt(void)
 {
-    int i;
-    _s >> i;
-    return i;
+    return readNumber<int>();
 }
 
 char Stream::readChar(void)
 {
-  char c;
-  return _s >> c, c;
+  skipSpace();
+  if (_pos >= _buffer.size())
+    return char();
+  return _buffer[_pos++];
 }
 
 float Stream::readFloat(void)
 {
-    float i;
-    _s >> i;
-    return i;
+    return readNumber<float>();
 }
 
 double Stream::readDouble(void)
 {
-    double i;
-    _s >> i;
-    return i;
+    return readNumber<double>();
 }
 
 std::string Stream::readString(void)
 {
-    std::string i;
-    _s >> i;
-    return i;
+    return std::string(readStringView());
+}
+
+std::string_view Stream::readStringView(void)
+{
+  skipSpace();
+  size_t start = _pos;
+  while (_pos < _buffer.size() && !IsSpace(_buffer[_pos]))
+    ++_pos;
+  if (_pos >= _buffer.size())
+    _eof = true;
+  return _buffer.substr(start, _pos - start);
 }
 
 std::string Stream::readAllLines(void)
 {
-    std::string h((std::istreambuf_iterator<char>(_s)), (std::istreambuf_iterator<char>()));
+    std::string h(_buffer.substr(std::min(_pos, _buffer.size())));
+    _pos = _buffer.size();
+    _eof = true;
     return h;
 }
 
 std::string Stream::readLine(void)
 {
-  std::string line;
-  return std::getline(_s, line), line == "" ? std::getline(_s, line) : _s , line;
+  return std::string(readLineView());
+}
+
+std::string_view Stream::readLineView(void)
+{
+  // Like getline, an empty line is skipped once
+  for (int tries = 0; tries < 2; ++tries)
+  {
+    if (_pos >= _buffer.size())
+    {
+      _eof = true;
+      return {};
+    }
+    size_t end = _buffer.find('\n', _pos);
+    std::string_view line;
+    if (end == std::string_view::npos)
+    {
+      line = _buffer.substr(_pos);
+      _pos = _buffer.size();
+      _eof = true;
+    }
+    else
+    {
+      line = _buffer.substr(_pos, end - _pos);
+      _pos = end + 1;
+    }
+    if (!line.empty())
+      return line;
+  }
+  return {};
 }
 
-
-
 glm::vec2 Stream::readVector(void)
 {
     glm::vec2 i;
-    _s >> i.x;
-    _s >> i.y;
+    i.x = readFloat();
+    i.y = readFloat();
     return i;
 }
 
 glm::vec4 Stream::readColor(void)
 {
     glm::vec4 i;
-    _s >> i.r;
-    _s >> i.g;
-    _s >> i.b;
-    _s >> i.a;
+    i.r = readFloat();
+    i.g = readFloat();
+    i.b = readFloat();
+    i.a = readFloat();
     return i;
 }
 
 bool Stream::readBool(void)
 {
-    std::string st;
-    _s >> st;
+    std::string_view st = readStringView();
     if (st == "TRUE" || st == "1" || st == "true" || st == "True")
         return true;
     return false;
@@ -127,12 +194,12 @@ bool Stream::readBool(void)
 
 bool Stream::Open()
 {
-    return _s.is_open();
+    return _file.Open();
 }
 
 bool Stream::isEOF()
 {
-    return _s.eof();
+    return _eof;
 }
 
 std::string Stream::Path()
@@ -8,15 +8,17 @@
  *********************************************************************/
 #pragma once
 
-#include <fstream>
 #include <glm.hpp>
 #include <string>
+#include <string_view>
+#include "Mapped File.h"
 enum class fileTypes : int
 {
   invalid = -1,
   dat,
   xml,
   obj,
+  binary,
 
 };
 /**
@@ -28,6 +30,49 @@ enum class fileTypes : int
 std::string makeLowerCase(std::string s);
 fileTypes GetFileType(std::string s);
 
+/**
+ * @brief Check if a character separates tokens, shared by every text parser.
+ *
+ * @param c the character
+ * @return whether it is whitespace
+ */
+inline bool IsSpace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+/**
+ * @brief Drop the whitespace from both ends of a string.
+ *
+ * @param s the string
+ * @return view of what is left
+ */
+inline std::string_view Trim(std::string_view s)
+{
+  while (!s.empty() && IsSpace(s.front()))
+    s.remove_prefix(1);
+  while (!s.empty() && IsSpace(s.back()))
+    s.remove_suffix(1);
+  return s;
+}
+/**
+ * @brief Take the next whitespace separated token off the front of a string.
+ *
+ * @param s the string, left pointing past the token
+ * @return the token, empty once nothing but whitespace is left
+ */
+inline std::string_view NextToken(std::string_view& s)
+{
+  size_t start = 0;
+  while (start < s.size() && IsSpace(s[start]))
+    ++start;
+  size_t end = start;
+  while (end < s.size() && !IsSpace(s[end]))
+    ++end;
+  std::string_view token = s.substr(start, end - start);
+  s.remove_prefix(end);
+  return token;
+}
+
 class Stream
 {
 public:
@@ -87,6 +132,12 @@ public:
      * @return the string read in
      */
     std::string readString(void);
+    /**
+     * @brief read a string from the stream without copying it
+     *
+     * @return view of the string, valid as long as the stream is
+     */
+    std::string_view readStringView(void);
     /**
      * @brief read all lines from the stream
      *
@@ -99,6 +150,12 @@ public:
      * @return the line read in
      */
     std::string readLine(void);
+    /**
+     * @brief Read the whole next line without copying it.
+     *
+     * @return view of the line, valid as long as the stream is
+     */
+    std::string_view readLineView(void);
     /**
      * @brief read an Vector from the stream
      *
@@ -137,6 +194,16 @@ public:
     std::string Path();
 
 private:
-    std::ifstream _s;
+    // Skip whitespace, sets eof if nothing is left
+    void skipSpace();
+    template<typename t>
+    t readNumber();
+
+    // The whole file is mapped and read in place, nothing goes through iostreams
+    MappedFile _file;
+    std::string_view _buffer;
+    size_t _pos = 0;
+    // Set once a read runs into the end of the file, the same as ifstream's eof
+    bool _eof = false;
     std::string _path;
 };
@@ -0,0 +1,55 @@
+#include "pch.h"
+#include "Submission Context.h"
+#include "Mesh.h"
+
+std::mutex SubmissionContext::_lock;
+std::vector<SubmissionContext*> SubmissionContext::_contexts;
+std::vector<stagedCall> SubmissionContext::_orphaned;
+
+SubmissionContext::SubmissionContext()
+{
+  std::lock_guard guard(_lock);
+  _contexts.push_back(this);
+}
+
+SubmissionContext::~SubmissionContext()
+{
+  std::lock_guard guard(_lock);
+  std::erase(_contexts, this);
+  _orphaned.insert(_orphaned.end(), _calls.begin(), _calls.end());
+}
+
+SubmissionContext& SubmissionContext::Local()
+{
+  thread_local SubmissionContext context;
+  return context;
+}
+
+void SubmissionContext::Add(ORB_Mesh* mesh, int lod)
+{
+  _calls.push_back({mesh, lod, matrix, color, material});
+}
+
+void SubmissionContext::Merge()
+{
+  std::lock_guard guard(_lock);
+  auto merge = [](std::vector<stagedCall>& calls)
+  {
+    for (auto const& call : calls)
+      call.mesh->AddCall({.matrix = call.matrix, .color = call.color, .materialID = call.material}, call.lod);
+    calls.clear();
+  };
+  for (auto* context : _contexts)
+    merge(context->_calls);
+  merge(_orphaned);
+}
+
+void SubmissionContext::Forget(ORB_Mesh const* mesh)
+{
+  std::lock_guard guard(_lock);
+  auto drop = [mesh](stagedCall const& call)
+  { return call.mesh == mesh; };
+  for (auto* context : _contexts)
+    std::erase_if(context->_calls, drop);
+  std::erase_if(_orphaned, drop);
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+#include <mutex>
+#include <glm.hpp>
+
+class ORB_Mesh;
+
+/**
+ * @brief A stored call waiting to be handed to its mesh.
+ */
+typedef struct stagedCall
+{
+  ORB_Mesh* mesh;
+  int lod;
+  glm::mat4 matrix;
+  glm::vec3 color;
+  int material;
+}stagedCall;
+
+/**
+ * @brief What one thread is drawing with in stored mode, and the calls it made since the last frame.
+ *
+ * @details Every thread gets its own context the first time it submits, so threads can set their matrix,
+ * color and material and draw stored meshes at the same time without locking. StoredUpdate merges the staged
+ * calls of every thread into their meshes once per frame, submissions for a frame have to be done by then.
+ * Calls a thread stages before it exits are kept until the merge.
+ */
+class SubmissionContext
+{
+public:
+  glm::mat4 matrix = glm::identity<glm::mat4>();
+  glm::vec4 color = {1, 1, 1, 1};
+  int material = 0;
+
+  ~SubmissionContext();
+
+  /**
+   * @brief Get the calling thread's context.
+   */
+  static SubmissionContext& Local();
+  /**
+   * @brief Stage a call of a mesh with the current matrix, color and material.
+   */
+  void Add(ORB_Mesh* mesh, int lod);
+
+  /**
+   * @brief Hand every thread's staged calls to their meshes, on the render thread.
+   */
+  static void Merge();
+  /**
+   * @brief Drop the staged calls of a mesh that is about to be deleted.
+   */
+  static void Forget(ORB_Mesh const* mesh);
+
+private:
+  SubmissionContext();
+  SubmissionContext(SubmissionContext const&) = delete;
+  SubmissionContext& operator=(SubmissionContext const&) = delete;
+
+  std::vector<stagedCall> _calls;
+
+  // Guards the list of contexts, not the calls in them
+  static std::mutex _lock;
+  static std::vector<SubmissionContext*> _contexts;
+  // Calls of threads that exited before the merge
+  static std::vector<stagedCall> _orphaned;
+};
@@ -2,11 +2,14 @@
 #include "TexturedMesh.h"
 #include "RenderBackend.h"
 #include "Wermal Reader.h"
+#include "Mesh Binary.h"
+#include "Obj Reader.h"
 extern Renderer* active;
 
  TexturedMesh::~TexturedMesh()
 {
-  TextureManager::Instance()->DropTexture(t);
+  if (t != nullptr)
+    TextureManager::Instance()->DropTexture(t);
 }
 
  void TexturedMesh::LoadTexture(const char* path)
@@ -24,26 +27,53 @@ void TexturedMesh::SetTexture(ORB_Texture* _t)
   t = _t;
 }
 
-void TexturedMesh::Read(std::string file)
+void TexturedMesh::Upload()
+{
+  this->ORB_Mesh::Upload();
+  if (!_texturePath.empty())
+    LoadTexture(_texturePath);
+}
+
+void TexturedMesh::Swap(ORB_Mesh& other)
+{
+  this->ORB_Mesh::Swap(other);
+  TexturedMesh& o = static_cast<TexturedMesh&>(other);
+  std::swap(t, o.t);
+  std::swap(_texturePath, o._texturePath);
+}
+
+void TexturedMesh::Load(std::string file)
 {
-  Stream s(file);
   fileTypes type = GetFileType(file.substr(file.rfind('.')));
   switch (type)
   {
+  case fileTypes::binary: {
+    MappedFile m(file);
+    _texturePath = ReadMeshTexture(m);
+    ReadBinary(std::move(m));
+  }
+    break;
+  case fileTypes::obj: {
+    ObjMesh obj = ::ReadObj(file);
+    _texturePath = obj.texture;
+    ReadObj(std::move(obj));
+  }
+    break;
   case fileTypes::dat: {
-    std::string token = makeLowerCase(s.readString());
+    WermalReader s(file);
+    std::string token = makeLowerCase(std::string(s.ReadToken()));
     if (token != "<texturedmesh>")
       return;
+    TexturedMesh::Read(s);
   }
     break;
   default:
     throw std::runtime_error("File type currently unhandled");
     return;
   }
-  TexturedMesh::Read(s);
 }
 
-void TexturedMesh::Read(Stream& file)
+void TexturedMesh::Read(WermalReader& file)
 {
   fileTypes type = GetFileType(file.Path().substr(file.Path().rfind('.')));
   switch (type)
@@ -53,10 +83,7 @@ void TexturedMesh::Read(Stream& file)
     auto p = ReadNextAttribute(file);
     if (p.first == false)
       break;
-    std::string path(p.second.get());
-    while (path[0] == ' ')
-      path.erase(path.begin());
-    t = TextureManager::Instance()->LoadTexture(path);
+    _texturePath = p.second;
   }
   break;
   default:
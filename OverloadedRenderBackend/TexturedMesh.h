@@ -11,11 +11,19 @@ public:
   
   void SetTexture(ORB_Texture* t);
 
-  void Read(std::string) override;
-  void Read(Stream& s) override;
+  using ORB_Mesh::Read;
+  void Read(WermalReader& s) override;
+  void Load(std::string) override;
+  void Upload() override;
+  void Swap(ORB_Mesh& other) override;
 
   void Execute() const override;
+  ORB_Texture* Texture() const override { return t; }
+
+  std::string const& TexturePath() const { return _texturePath; }
 
 private:
-  ORB_Texture* t;
+  ORB_Texture* t = nullptr;
+  // Read from the mesh file, the texture itself is only loaded once the mesh is uploaded
+  std::string _texturePath;
 };
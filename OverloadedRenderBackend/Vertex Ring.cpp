@@ -0,0 +1,87 @@
+#include "pch.h"
+#include "Vertex Ring.h"
+
+VertexRing::VertexRing(std::vector<vertexAttribute> const& layout, size_t stride, std::span<const char> verticies)
+    : _layout(layout), _stride(stride), _count(verticies.size() / stride), _shadow(verticies.begin(), verticies.end())
+{
+  // Coherent, so writes through the mapping need no flush before the draw
+  GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  size_t regionBytes = _count * _stride;
+  glCreateBuffers(1, &_buffer);
+  glNamedBufferStorage(_buffer, regionBytes * VertexRingRegions, nullptr, flags);
+  _mapped = static_cast<char*>(glMapNamedBufferRange(_buffer, 0, regionBytes * VertexRingRegions, flags));
+  for (size_t i = 0; i < VertexRingRegions; ++i)
+  {
+    std::memcpy(_mapped + i * regionBytes, _shadow.data(), regionBytes);
+    _staleFirst[i] = _count;
+    _staleEnd[i] = 0;
+  }
+
+  glGenVertexArrays(1, &_vao);
+  glBindVertexArray(_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+  BindVertexLayout(_layout, _stride);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+}
+
+VertexRing::~VertexRing()
+{
+  for (auto fence : _fences)
+    if (fence)
+      glDeleteSync(fence);
+  glUnmapNamedBuffer(_buffer);
+  glDeleteBuffers(1, &_buffer);
+  glDeleteVertexArrays(1, &_vao);
+}
+
+void VertexRing::Write(size_t offset, std::span<const Vertex> verticies)
+{
+  std::span<const char> bytes(reinterpret_cast<const char*>(verticies.data()), verticies.size_bytes());
+  if (!IsVertexLayout(_layout, _stride))
+  {
+    PackVerticies(verticies, _layout, _stride, _packed);
+    bytes = _packed;
+  }
+  std::copy(bytes.begin(), bytes.end(), _shadow.begin() + offset * _stride);
+  for (size_t i = 0; i < VertexRingRegions; ++i)
+  {
+    _staleFirst[i] = std::min(_staleFirst[i], offset);
+    _staleEnd[i] = std::max(_staleEnd[i], offset + verticies.size());
+  }
+
+  size_t next = (_current + 1) % VertexRingRegions;
+  if (_fences[next])
+  {
+    // Only blocks when the GPU is still drawing with a copy from a whole ring ago
+    GLenum wait = glClientWaitSync(_fences[next], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    while (wait == GL_TIMEOUT_EXPIRED)
+      wait = glClientWaitSync(_fences[next], 0, 1000000);
+    glDeleteSync(_fences[next]);
+    _fences[next] = nullptr;
+  }
+  size_t first = _staleFirst[next];
+  size_t end = _staleEnd[next];
+  std::memcpy(_mapped + (next * _count + first) * _stride, _shadow.data() + first * _stride, (end - first) * _stride);
+  _staleFirst[next] = _count;
+  _staleEnd[next] = 0;
+  _current = next;
+}
+
+GLuint VertexRing::VAO(GLuint indexBuffer) const
+{
+  glVertexArrayElementBuffer(_vao, indexBuffer);
+  return _vao;
+}
+
+GLint VertexRing::BaseVertex() const
+{
+  return static_cast<GLint>(_current * _count);
+}
+
+void VertexRing::Fence()
+{
+  if (_fences[_current])
+    glDeleteSync(_fences[_current]);
+  _fences[_current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
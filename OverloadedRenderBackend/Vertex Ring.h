@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+#include <span>
+#include "Vertex.h"
+
+// How many copies of the verticies a ring keeps, the GPU can be reading two while the third is written
+constexpr size_t VertexRingRegions = 3;
+
+/**
+ * @brief The verticies of a mesh that changes every frame, in a persistently mapped buffer holding several copies.
+ *
+ * @details Every write goes to the copy after the latest one, so the CPU never writes what the GPU is reading
+ * and nothing is reallocated. A fence after each draw tells when a copy is free again, a write only waits when
+ * the GPU is a whole ring behind. Copies are brought up to date with just the verticies that changed since
+ * they were last written.
+ */
+class VertexRing
+{
+public:
+  /**
+   * @param layout how the verticies are laid out
+   * @param stride the size of one vertex in bytes
+   * @param verticies the verticies to start with, already in the layout
+   */
+  VertexRing(std::vector<vertexAttribute> const& layout, size_t stride, std::span<const char> verticies);
+  ~VertexRing();
+  VertexRing(VertexRing const&) = delete;
+  VertexRing& operator=(VertexRing const&) = delete;
+
+  /**
+   * @brief Replace some of the verticies, draws after this use them.
+   *
+   * @param offset the first vertex to replace
+   * @param verticies the new verticies
+   */
+  void Write(size_t offset, std::span<const Vertex> verticies);
+  /**
+   * @brief Get the VAO to draw with.
+   *
+   * @param indexBuffer the buffer the mesh's indicies are in, arenas move them when they repack
+   */
+  GLuint VAO(GLuint indexBuffer) const;
+  /**
+   * @brief Get the first vertex of the latest copy.
+   */
+  GLint BaseVertex() const;
+  /**
+   * @brief Mark the latest copy as read by what was just drawn.
+   */
+  void Fence();
+
+private:
+  std::vector<vertexAttribute> _layout;
+  size_t _stride;
+  size_t _count;
+  // The latest verticies, stale copies are brought up to date from here
+  std::vector<char> _shadow;
+  std::vector<char> _packed;
+  GLuint _buffer = 0;
+  GLuint _vao = 0;
+  char* _mapped = nullptr;
+  GLsync _fences[VertexRingRegions] = {};
+  // The verticies each copy is missing, empty when the first is past the end
+  size_t _staleFirst[VertexRingRegions];
+  size_t _staleEnd[VertexRingRegions];
+  size_t _current = 0;
+};
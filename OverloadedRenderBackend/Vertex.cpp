@@ -1,8 +1,294 @@
 #include "pch.h"
 #include "Vertex.h"
+#include <cstring>
 
 std::ostream& operator<<(std::ostream& os, Vertex const& v)
 {
     os << std::format("Pos: ({}, {}) Color: ({}, {}, {}, {}) Tex: ({}, {})", v.pos.x, v.pos.y, v.color.r, v.color.g, v.color.b, v.color.a, v.tex.x, v.tex.y);
     return os;
 }
+
+// Shaders take the Vertex members at these locations, anything past them gets 0
+constexpr size_t VertexMemberOffsets[] = {offsetof(Vertex, pos), offsetof(Vertex, color), offsetof(Vertex, normal), offsetof(Vertex, tex)};
+constexpr size_t VertexMemberSizes[] = {4, 4, 4, 2};
+
+bool ParseAttributeType(std::string_view name, vertexAttribute& attribute)
+{
+  struct typeName
+  {
+    std::string_view name;
+    GLenum type;
+    bool normalized;
+    bool integer;
+  };
+  static const typeName types[] = {
+      {"float", GL_FLOAT, false, false},
+      {"half", GL_HALF_FLOAT, false, false},
+      {"unorm8", GL_UNSIGNED_BYTE, true, false},
+      {"snorm8", GL_BYTE, true, false},
+      {"unorm16", GL_UNSIGNED_SHORT, true, false},
+      {"snorm16", GL_SHORT, true, false},
+      {"uint8", GL_UNSIGNED_BYTE, false, true},
+      {"int8", GL_BYTE, false, true},
+      {"uint16", GL_UNSIGNED_SHORT, false, true},
+      {"int16", GL_SHORT, false, true},
+      {"uint", GL_UNSIGNED_INT, false, true},
+      {"int", GL_INT, false, true},
+  };
+  // Octahedral normals are 2 snorm16s that the shader decodes
+  if (name == "oct")
+  {
+    attribute.type = GL_SHORT;
+    attribute.normalized = true;
+    attribute.integer = false;
+    attribute.oct = true;
+    attribute.size = 2;
+    return true;
+  }
+  for (auto const& t : types)
+  {
+    if (t.name != name)
+      continue;
+    attribute.type = t.type;
+    attribute.normalized = t.normalized;
+    attribute.integer = t.integer;
+    return true;
+  }
+  return false;
+}
+
+size_t AttributeBytes(vertexAttribute const& attribute)
+{
+  switch (attribute.type)
+  {
+  case GL_HALF_FLOAT:
+  case GL_UNSIGNED_SHORT:
+  case GL_SHORT:
+    return attribute.size * 2;
+  case GL_UNSIGNED_BYTE:
+  case GL_BYTE:
+    return attribute.size;
+  default:
+    return attribute.size * 4;
+  }
+}
+
+static std::vector<vertexAttribute> MakeLayout(std::vector<vertexAttribute> layout)
+{
+  size_t offset = 0;
+  for (auto& in : layout)
+  {
+    in.offset = offset;
+    offset += AttributeBytes(in);
+  }
+  return layout;
+}
+
+std::vector<vertexAttribute> const& FormatLayout(VertexFormat format)
+{
+  static const std::vector<vertexAttribute> full = MakeLayout({{0, 4}, {1, 4}, {2, 4}, {3, 2}});
+  static const std::vector<vertexAttribute> compact = MakeLayout({
+      {0, 4, GL_HALF_FLOAT},
+      {1, 4, GL_UNSIGNED_BYTE, true},
+      {2, 2, GL_SHORT, true, false, true},
+      {3, 2, GL_UNSIGNED_SHORT, true},
+  });
+  static const std::vector<vertexAttribute> compact2D = MakeLayout({
+      {0, 2, GL_HALF_FLOAT},
+      {1, 4, GL_UNSIGNED_BYTE, true},
+      {3, 2, GL_UNSIGNED_SHORT, true},
+  });
+  switch (format)
+  {
+  case VertexFormat::Compact:
+    return compact;
+  case VertexFormat::Compact2D:
+    return compact2D;
+  default:
+    return full;
+  }
+}
+
+size_t FormatStride(VertexFormat format)
+{
+  auto const& layout = FormatLayout(format);
+  return layout.back().offset + AttributeBytes(layout.back());
+}
+
+bool IsVertexLayout(std::vector<vertexAttribute> const& layout, size_t stride)
+{
+  if (stride != sizeof(Vertex) || layout.size() != std::size(VertexMemberOffsets))
+    return false;
+  for (size_t i = 0; i < layout.size(); ++i)
+  {
+    if (layout[i].location != i || layout[i].size != VertexMemberSizes[i] || layout[i].type != GL_FLOAT ||
+        layout[i].integer || layout[i].oct || layout[i].offset != VertexMemberOffsets[i])
+      return false;
+  }
+  return true;
+}
+
+// Octahedral encoding, the normal is folded onto a square so it fits in 2 components
+static glm::vec2 OctEncode(glm::vec3 n)
+{
+  float sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+  if (sum == 0)
+    return {0, 0};
+  n /= sum;
+  glm::vec2 e = {n.x, n.y};
+  if (n.z < 0)
+    e = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * glm::vec2(n.x >= 0 ? 1.0f : -1.0f, n.y >= 0 ? 1.0f : -1.0f);
+  return e;
+}
+
+// Write count floats as the attribute's type
+static void PackComponents(float const* in, size_t count, vertexAttribute const& attribute, char* out)
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    float f = in[i];
+    switch (attribute.type)
+    {
+    case GL_HALF_FLOAT:
+    {
+      uint16_t h = glm::packHalf1x16(f);
+      std::memcpy(out + i * 2, &h, 2);
+    }
+    break;
+    case GL_UNSIGNED_BYTE:
+      out[i] = static_cast<char>(attribute.normalized ? glm::packUnorm1x8(f) : static_cast<uint8_t>(f));
+      break;
+    case GL_BYTE:
+      out[i] = static_cast<char>(attribute.normalized ? glm::packSnorm1x8(f) : static_cast<int8_t>(f));
+      break;
+    case GL_UNSIGNED_SHORT:
+    {
+      uint16_t v = attribute.normalized ? glm::packUnorm1x16(f) : static_cast<uint16_t>(f);
+      std::memcpy(out + i * 2, &v, 2);
+    }
+    break;
+    case GL_SHORT:
+    {
+      int16_t v = attribute.normalized ? static_cast<int16_t>(glm::packSnorm1x16(f)) : static_cast<int16_t>(f);
+      std::memcpy(out + i * 2, &v, 2);
+    }
+    break;
+    case GL_UNSIGNED_INT:
+    {
+      uint32_t v = static_cast<uint32_t>(f);
+      std::memcpy(out + i * 4, &v, 4);
+    }
+    break;
+    case GL_INT:
+    {
+      int32_t v = static_cast<int32_t>(f);
+      std::memcpy(out + i * 4, &v, 4);
+    }
+    break;
+    default:
+      std::memcpy(out + i * 4, &f, 4);
+      break;
+    }
+  }
+}
+
+void BindVertexLayout(std::vector<vertexAttribute> const& layout, size_t stride)
+{
+  for (auto const& in : layout)
+  {
+    glEnableVertexAttribArray(in.location);
+    if (in.integer)
+      glVertexAttribIPointer(
+          in.location,
+          static_cast<GLint>(in.size),
+          in.type,
+          static_cast<GLsizei>(stride),
+          reinterpret_cast<void*>(in.offset));
+    else
+      glVertexAttribPointer(
+          in.location,
+          static_cast<GLint>(in.size),
+          in.type,
+          in.normalized ? GL_TRUE : GL_FALSE,
+          static_cast<GLsizei>(stride),
+          reinterpret_cast<void*>(in.offset));
+  }
+}
+
+void PackVerticies(std::span<const Vertex> verticies, std::vector<vertexAttribute> const& layout, size_t stride, std::vector<char>& out)
+{
+  out.assign(verticies.size() * stride, 0);
+  for (auto const& in : layout)
+  {
+    if (in.location >= std::size(VertexMemberOffsets))
+      continue;
+    size_t source = VertexMemberOffsets[in.location];
+    size_t count = std::min(in.size, VertexMemberSizes[in.location]);
+    char* dest = out.data() + in.offset;
+    // Plain floats are a fixed size copy per vertex, which compiles to vector moves
+    if (in.type == GL_FLOAT && !in.oct)
+    {
+      size_t bytes = count * sizeof(float);
+      if (bytes == sizeof(glm::vec4))
+      {
+        for (size_t i = 0; i < verticies.size(); ++i, dest += stride)
+          std::memcpy(dest, reinterpret_cast<char const*>(&verticies[i]) + source, sizeof(glm::vec4));
+      }
+      else
+      {
+        for (size_t i = 0; i < verticies.size(); ++i, dest += stride)
+          std::memcpy(dest, reinterpret_cast<char const*>(&verticies[i]) + source, bytes);
+      }
+      continue;
+    }
+    for (size_t i = 0; i < verticies.size(); ++i, dest += stride)
+    {
+      float const* member = reinterpret_cast<float const*>(reinterpret_cast<char const*>(&verticies[i]) + source);
+      if (in.oct)
+      {
+        glm::vec2 e = OctEncode(glm::vec3(member[0], member[1], member[2]));
+        PackComponents(&e.x, 2, in, dest);
+      }
+      else
+        PackComponents(member, count, in, dest);
+    }
+  }
+}
+
+static_assert(sizeof(Vertex) % sizeof(uint64_t) == 0, "Vertex is hashed a word at a time");
+
+static uint64_t HashVertex(Vertex const& v)
+{
+  constexpr uint64_t prime = 0x100000001b3;
+  uint64_t hash = 0xcbf29ce484222325;
+  uint64_t words[sizeof(Vertex) / sizeof(uint64_t)];
+  std::memcpy(words, &v, sizeof(words));
+  for (uint64_t word : words)
+    hash = (hash ^ word) * prime;
+  // FNV leaves the low bits weak, they pick the slot
+  return hash ^ (hash >> 32);
+}
+
+void WeldVerticies(std::vector<Vertex>& verticies, std::vector<uint32_t>& indicies)
+{
+  constexpr uint32_t empty = UINT32_MAX;
+  indicies.resize(verticies.size());
+  // Open addressing kept at most half full, slots hold indicies into the welded verticies
+  size_t capacity = std::bit_ceil(verticies.size() * 2 + 1);
+  std::vector<uint32_t> slots(capacity, empty);
+  uint32_t unique = 0;
+  for (size_t i = 0; i < verticies.size(); ++i)
+  {
+    size_t slot = HashVertex(verticies[i]) & (capacity - 1);
+    while (slots[slot] != empty && std::memcmp(&verticies[slots[slot]], &verticies[i], sizeof(Vertex)) != 0)
+      slot = (slot + 1) & (capacity - 1);
+    // Welded verticies are written over the front of the list, which has already been read
+    if (slots[slot] == empty)
+    {
+      verticies[unique] = verticies[i];
+      slots[slot] = unique++;
+    }
+    indicies[i] = slots[slot];
+  }
+  verticies.resize(unique);
+}
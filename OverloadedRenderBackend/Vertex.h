@@ -1,6 +1,9 @@
 #pragma once
 #include <iostream>
 #include <format>
+#include <span>
+#include <string_view>
+#include <vector>
 #pragma pack(8)
 typedef struct Vertex
 {
@@ -10,5 +13,101 @@ typedef struct Vertex
   glm::vec2 tex;
 }Vertex;
 
+/**
+ * @brief How verticies are stored on the GPU.
+ *
+ * @details Full - Vertex as is, 56 bytes
+ *          Compact - half float position, unorm8 color, oct encoded snorm16 normal, unorm16 UV. 20 bytes
+ *          Compact2D - half float xy, unorm8 color, unorm16 UV and no normal. 12 bytes
+ *
+ * The compact formats clamp UVs to 0-1 and keep positions to half float precision.
+ */
+enum class VertexFormat : int
+{
+  Full,
+  Compact,
+  Compact2D
+};
+
+/**
+ * @brief One input in an interleaved vertex buffer.
+ *
+ * @details location - the attribute location, 0-3 take pos, color, normal and tex from Vertex
+ *          size - how many components it has
+ *          type - the GL type of each component
+ *          normalized - integer types are read as 0-1 (or -1-1) floats
+ *          integer - integer types are read as ints, see glVertexAttribIPointer
+ *          oct - the 3 component normal is stored as a 2 component octahedral encoding
+ *          offset - how many bytes come before it in each vertex
+ */
+typedef struct vertexAttribute
+{
+  GLuint location;
+  size_t size;
+  GLenum type = GL_FLOAT;
+  bool normalized = false;
+  bool integer = false;
+  bool oct = false;
+  size_t offset = 0;
+}vertexAttribute;
+
+/**
+ * @brief Set the type of an attribute from its name in a .meta file.
+ *
+ * @param name - float, half, unorm8, snorm8, unorm16, snorm16, uint8, int8, uint16, int16, uint, int or oct
+ * @param attribute - the attribute to set
+ * @return false if the name is not a type
+ */
+bool ParseAttributeType(std::string_view name, vertexAttribute& attribute);
+/**
+ * @brief Get how many bytes an attribute takes in a vertex.
+ */
+size_t AttributeBytes(vertexAttribute const& attribute);
+
+/**
+ * @brief Get the layout the shaders see for a vertex format.
+ *
+ * @param format the format
+ * @return the attributes with their offsets set
+ */
+std::vector<vertexAttribute> const& FormatLayout(VertexFormat format);
+/**
+ * @brief Get the size of one vertex of a format in bytes.
+ */
+size_t FormatStride(VertexFormat format);
+
+/**
+ * @brief Whether a layout reads Vertex exactly as it is in memory, in which case nothing needs packing.
+ *
+ * @param layout the attributes, sorted by location
+ * @param stride the size of one vertex in bytes
+ */
+bool IsVertexLayout(std::vector<vertexAttribute> const& layout, size_t stride);
+/**
+ * @brief Convert verticies into an interleaved layout.
+ *
+ * @param verticies the verticies
+ * @param layout the attributes to write, offsets must be set
+ * @param stride the size of one vertex in bytes
+ * @param out where to write, resized to fit
+ */
+void PackVerticies(std::span<const Vertex> verticies, std::vector<vertexAttribute> const& layout, size_t stride, std::vector<char>& out);
+/**
+ * @brief Point the attributes of the bound VAO at the bound GL_ARRAY_BUFFER.
+ *
+ * @param layout the attributes, offsets must be set
+ * @param stride the size of one vertex in bytes
+ */
+void BindVertexLayout(std::vector<vertexAttribute> const& layout, size_t stride);
+
+/**
+ * @brief Merge identical verticies and build the indicies that draw them in the original order.
+ *
+ * @details Verticies are only merged when every byte matches
+ * @param verticies the verticies, replaced by the unique ones in order of first use
+ * @param indicies where to write the indicies, one for each original vertex
+ */
+void WeldVerticies(std::vector<Vertex>& verticies, std::vector<uint32_t>& indicies);
+
 
 std::ostream& operator<<(std::ostream& os, Vertex const& v);
@@ -1,45 +1,99 @@
 #include "pch.h"
 #include "Wermal Reader.h"
 
-Data ReadNextAttribute(Stream& source)
+WermalReader::WermalReader(std::string const& path) : _file(path), _path(path)
 {
+  _buffer = _file.View();
+}
+
+WermalReader::WermalReader(std::string_view buffer) : _buffer(buffer)
+{
+}
+
+std::string_view WermalReader::ReadToken()
+{
+  while (_pos < _buffer.size() && IsSpace(_buffer[_pos]))
+    ++_pos;
+  size_t start = _pos;
+  while (_pos < _buffer.size() && !IsSpace(_buffer[_pos]))
+    ++_pos;
+  return _buffer.substr(start, _pos - start);
+}
 
-  std::string tokens;
-  size_t lastpos = source.location();
-  tokens = source.readLine();
-  if(tokens == "\r")
-    tokens = source.readLine();
-  if (source.isEOF())
-    return { false, nullptr };
-  if (tokens.find('<') != std::string::npos) 
+std::string_view WermalReader::ReadLine()
+{
+  while (_pos < _buffer.size())
   {
-    tokens = source.readLine();
-    // I hate this so much 
-    std::shared_ptr<char> data(new char[tokens.size() + 1]);
-    std::memcpy(data.get(), tokens.c_str(), tokens.size());
-    data.get()[tokens.size()] = '\0';
-    return { true, data};
+    size_t end = _buffer.find('\n', _pos);
+    if (end == std::string_view::npos)
+      end = _buffer.size();
+    std::string_view line = _buffer.substr(_pos, end - _pos);
+    _pos = end + 1;
+    if (!line.empty() && line.back() == '\r')
+      line.remove_suffix(1);
+    if (!Trim(line).empty())
+      return line;
   }
-  return { false, nullptr };
+  _pos = _buffer.size();
+  return {};
 }
 
-parseResults ReadNextAttribute(Stream& source, bool)
+Data ReadNextAttribute(WermalReader& source)
 {
-  return { types::Failed, nullptr };
+  std::string_view tag = Trim(source.ReadLine());
+  if (tag.empty() || tag.find('<') == std::string_view::npos)
+    return { false, {} };
+  // A closing tag means there is nothing left in this block
+  if (tag.starts_with("</"))
+    return { false, {} };
+  std::string_view data = Trim(source.ReadLine());
+  if (data.empty())
+    return { false, {} };
+  return { true, data };
 }
 
-parseResults ReadNextAttribute(Stream& source, int hint)
+parseResults ReadNextAttribute(WermalReader& source, int hint)
 {
-  return { types::Failed, nullptr };
-
+  auto d = ReadNextAttribute(source);
+  if (d.first == false)
+    return {};
+  return TryParse(d.second, hint);
 }
 
-parseResults TryParse(std::shared_ptr<char> c)
+parseResults TryParse(std::string_view c)
 {
-  return { types::Failed, nullptr };
+  return TryParse(c, 0);
 }
 
-parseResults TryParse(std::shared_ptr<char> c, int hint)
+parseResults TryParse(std::string_view c, int hint)
 {
-  return { types::Failed, nullptr };
+  parseResults res;
+  size_t count = MaxParsedValues;
+  if (hint > 0 && static_cast<size_t>(hint) < MaxParsedValues)
+    count = static_cast<size_t>(hint);
+
+  // Anything with a decimal point or exponent in it is a float, otherwise it is an int
+  res.type = types::Int;
+  std::string_view rest = c;
+  size_t tokens = 0;
+  while (tokens < count)
+  {
+    std::string_view token = NextToken(rest);
+    if (token.empty())
+      break;
+    if (token.find_first_of(".eEnN") != std::string_view::npos)
+      res.type = types::Float;
+    ++tokens;
+  }
+  if (tokens == 0)
+    return {};
+
+  if (res.type == types::Int)
+    res.count = Parse<int>(c, res.ints, tokens);
+  else
+    res.count = Parse<float>(c, res.floats, tokens);
+
+  if (res.count != tokens || (hint > 0 && res.count < static_cast<size_t>(hint)))
+    return {};
+  return res;
 }
@@ -1,6 +1,8 @@
 #pragma once
-#include <vector>
-#include <sstream>
+#include <string>
+#include <string_view>
+#include <charconv>
+#include "Mapped File.h"
 #include "Stream.h"
 
 enum class types : int
@@ -12,55 +14,143 @@ enum class types : int
 
 /**
  * @brief Information about a single data value.
- * 
+ *
  * bool - state either valid read or invalid
- * char* - pointer to read in string
+ * string_view - the data line, points into the reader's buffer
  */
-typedef std::pair<bool, std::shared_ptr<char>> Data;
-typedef std::pair<types, void*> parseResults;
+typedef std::pair<bool, std::string_view> Data;
 
+// The most values TryParse will read out of a single attribute
+constexpr size_t MaxParsedValues = 16;
+
+/**
+ * @brief The values read out of an attribute by TryParse.
+ *
+ * type - what the data was guessed to be, Failed if it could not be parsed
+ * count - how many values were read
+ * ints/floats - the values, only the array matching type is filled
+ */
+typedef struct parseResults
+{
+  types type = types::Failed;
+  size_t count = 0;
+  int ints[MaxParsedValues];
+  float floats[MaxParsedValues];
+}parseResults;
+
+/**
+ * @brief Tokenizer over a whole Werml file held in memory.
+ *
+ * Everything handed out is a view into the buffer, nothing is allocated while reading.
+ */
+class WermalReader
+{
+public:
+  /**
+   * @brief Map a whole file for reading.
+   *
+   * @param path the file to read
+   */
+  WermalReader(std::string const& path);
+  /**
+   * @brief Read from a buffer the caller keeps alive.
+   *
+   * @param buffer the data to read
+   */
+  WermalReader(std::string_view buffer);
+
+  /**
+   * @brief Read the next whitespace separated token.
+   *
+   * @return the token, empty at the end of the buffer
+   */
+  std::string_view ReadToken();
+  /**
+   * @brief Read the next line that is not blank.
+   *
+   * @return the line without its line ending, empty at the end of the buffer
+   */
+  std::string_view ReadLine();
+
+  bool isEOF() const { return _pos >= _buffer.size(); }
+  size_t location() const { return _pos; }
+  void Seek(size_t pos) { _pos = std::min(pos, _buffer.size()); }
+  std::string_view Buffer() const { return _buffer; }
+  std::string const& Path() const { return _path; }
+
+private:
+  MappedFile _file;
+  std::string_view _buffer;
+  size_t _pos = 0;
+  std::string _path;
+};
 
 /**
  * @brief Read the next attribute in the data stream
 
  * @param source - File stream source
- * @return pair stating whether the data was read, and a pointer to the data
+ * @return pair stating whether the data was read, and a view of the data. Closing tags end the data.
+ */
+Data ReadNextAttribute(WermalReader& source);
+/**
+ * @brief Read the next attribute and guess its type.
+ *
+ * @param source - File stream source
+ * @param hint - How many values the attribute should hold, 0 if unknown
  */
-Data ReadNextAttribute(Stream& source);
-parseResults ReadNextAttribute(Stream& source, bool);
-parseResults ReadNextAttribute(Stream& source, int hint);
+parseResults ReadNextAttribute(WermalReader& source, int hint);
 
 /**
- * @brief Forfully parse the data stream as a type t.
- * 
+ * @brief Forcefully parse the data as a series of t.
+ *
  * @param c - the data to be parsed
- * @return a shared pointer to the read in data.
+ * @param out - where to write the values
+ * @param count - the most values to read
+ * @return how many values were read, stops at the first value that is not a t.
  */
 template<typename t>
-std::shared_ptr<t> Parse(std::shared_ptr<char> c)
+size_t Parse(std::string_view c, t* out, size_t count)
 {
-  std::stringstream s(c.get());
-  std::vector<t> results;
-  while (!s.eof()) 
+  const char* it = c.data();
+  const char* end = c.data() + c.size();
+  size_t read = 0;
+  while (read < count)
   {
-    t temp;
-    s >> temp;
-    results.push_back(temp);
-
+    while (it != end && IsSpace(*it))
+      ++it;
+    // from_chars does not take a leading +
+    if (it != end && *it == '+')
+      ++it;
+    if (it == end)
+      break;
+    auto res = std::from_chars(it, end, out[read]);
+    if (res.ec != std::errc())
+      break;
+    it = res.ptr;
+    ++read;
   }
-  std::shared_ptr<t> res(new t[results.size()]);
-  memcpy(res.get(), results.data(), results.size() * sizeof(t));
-  return res;
+  return read;
+}
+
+/**
+ * @brief Forcefully parse the first value of the data as a t.
+ *
+ * @param c - the data to be parsed
+ * @return the value, a default t if there was none
+ */
+template<typename t>
+t Parse(std::string_view c)
+{
+  t value = t();
+  Parse<t>(c, &value, 1);
+  return value;
 }
 
 /**
  * @brief Attempt to parse and guess the type of data in the stream.
- * 
+ *
  * @param c - the data stream
- * @param hint - A hint to how many values are in the stream.
+ * @param hint - A hint to how many values are in the stream, fails if there are fewer.
  */
-parseResults TryParse(std::shared_ptr<char> c);
-parseResults TryParse(std::shared_ptr<char> c, int hint);
-
-
-
+parseResults TryParse(std::string_view c);
+parseResults TryParse(std::string_view c, int hint);